@@ -0,0 +1,386 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "event_compress.h"
+#include "event_queue.h"
+#include "event_stage.h"
+#include "slot_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Micro benchmarks, run with ./bench in an optimized build
+
+#define BENCH_RING_SIZE (uint32_t)(16 * 1024 * 1024)
+#define BENCH_BYTES (uint64_t)(1024 * 1024 * 1024)
+
+typedef void (*copy_func_t)(void *dst, const void *src, uint32_t len);
+
+static volatile uint32_t sink;
+
+static void copy_libc(void *dst, const void *src, uint32_t len) {
+  memcpy(dst, src, len);
+}
+
+static void copy_small(void *dst, const void *src, uint32_t len) {
+  event_copy_small(dst, src, len);
+}
+
+static void copy_stream(void *dst, const void *src, uint32_t len) {
+  event_copy_stream(dst, src, len);
+}
+
+static uint64_t iterations(const uint32_t size) {
+  const uint64_t n = BENCH_BYTES / (size + 64);
+  return (n > 50000000) ? 50000000 : n;
+}
+
+/**
+ * Time copying payloads of a size into successive ring positions
+ */
+static double bench_copy(copy_func_t copy, uint8_t *const ring,
+                         const uint8_t *const src, const uint32_t size) {
+  const uint64_t n = iterations(size);
+  uint32_t offset = 0;
+  const uint64_t start = event_clock_monotonic_ns();
+  for (uint64_t i = 0; i < n; i++) {
+    copy(ring + offset, src, size + (uint32_t)(i & sink));
+    offset += (size + 7) & ~7U;
+    if (offset + size > BENCH_RING_SIZE) {
+      offset = 0;
+    }
+  }
+  return (double)(event_clock_monotonic_ns() - start) / (double)n;
+}
+
+/**
+ * Time copying payloads of a size while the producer works on a hot data set
+ *
+ *  Cached copies evict the hot data set, streaming stores leave it in cache.
+ */
+static double bench_copy_hot_set(copy_func_t copy, uint8_t *const ring,
+                                 const uint8_t *const src, const uint32_t size,
+                                 const uint32_t *const hot_set,
+                                 const uint32_t hot_set_len) {
+  const uint64_t n = iterations(size) / 16;
+  uint32_t offset = 0;
+  uint32_t checksum = 0;
+  const uint64_t start = event_clock_monotonic_ns();
+  for (uint64_t i = 0; i < n; i++) {
+    copy(ring + offset, src, size);
+    offset += (size + 7) & ~7U;
+    if (offset + size > BENCH_RING_SIZE) {
+      offset = 0;
+    }
+    for (uint32_t j = 0; j < hot_set_len; j += 16) {
+      checksum += hot_set[j];
+    }
+  }
+  sink = checksum;
+  return (double)(event_clock_monotonic_ns() - start) / (double)n;
+}
+
+/**
+ * Time a put and pop of payloads of a size, reading the payload back
+ */
+static double bench_queue(uint8_t *const ring, const uint8_t *const src,
+                          const uint32_t size, const uint32_t threshold) {
+  event_queue_t eq;
+  event_queue_config_t eq_config = {.buffer = ring,
+                                    .buffer_len = BENCH_RING_SIZE,
+                                    .alignment = 8,
+                                    .use_atomics = true,
+                                    .copy_stream_threshold = threshold};
+  event_queue_init(&eq, &eq_config);
+
+  // Keep a quarter of the ring queued, the consumer lags the producer
+  const uint64_t n = iterations(size);
+  const uint64_t lag = (BENCH_RING_SIZE / 4) / (size + 32);
+  uint32_t checksum = 0;
+  const uint64_t start = event_clock_monotonic_ns();
+  for (uint64_t i = 0; i < n; i++) {
+    event_queue_put(&eq, (event_id_t)i, (void *)src, size);
+    if (i >= lag) {
+      event_t *const evt = event_queue_get(&eq);
+      const uint8_t *const data = (const uint8_t *)evt->event_data;
+      for (uint32_t j = 0; j < evt->event_data_length; j += 64) {
+        checksum += data[j];
+      }
+      event_queue_pop(&eq);
+    }
+  }
+  const double ns = (double)(event_clock_monotonic_ns() - start) / (double)n;
+  sink = checksum;
+  return ns;
+}
+
+/**
+ * Time a put, get and pop of a fixed size event
+ */
+static double bench_fixed_size(uint8_t *const ring, const uint8_t *const src,
+                               const uint32_t size, const bool slots) {
+  event_queue_t eq;
+  event_queue_config_t eq_config = {.buffer = ring,
+                                    .buffer_len = BENCH_RING_SIZE,
+                                    .alignment = 8,
+                                    .use_atomics = true};
+  slot_queue_t sq;
+  slot_queue_config_t sq_config = {.buffer = ring,
+                                   .buffer_len = BENCH_RING_SIZE,
+                                   .slot_size = size,
+                                   .alignment = 8,
+                                   .use_atomics = true};
+  event_queue_init(&eq, &eq_config);
+  slot_queue_init(&sq, &sq_config);
+
+  const uint64_t n = iterations(size);
+  uint32_t checksum = 0;
+  const uint64_t start = event_clock_monotonic_ns();
+  for (uint64_t i = 0; i < n; i++) {
+    if (slots) {
+      slot_queue_put(&sq, src);
+      checksum += *(uint8_t *)slot_queue_get(&sq);
+      slot_queue_pop(&sq);
+    } else {
+      event_queue_put(&eq, 0, (void *)src, size);
+      checksum += *(uint8_t *)event_queue_get(&eq)->event_data;
+      event_queue_pop(&eq);
+    }
+  }
+  const double ns = (double)(event_clock_monotonic_ns() - start) / (double)n;
+  sink = checksum;
+  return ns;
+}
+
+// Telemetry style payload, key value text with slowly changing values
+static void telemetry_payload(uint8_t *const dst, const uint32_t size) {
+  uint32_t len = 0;
+  for (uint32_t i = 0; len < size; i++) {
+    char line[96];
+    const int n = snprintf(line, sizeof(line),
+                           "ts=%u,host=node-17,cpu=%u,temp_c=%u,fan_rpm=%u;",
+                           1700000000U + i, i % 64, 40 + i % 7, 3000 + i % 50);
+    const uint32_t copy = ((uint32_t)n < size - len) ? (uint32_t)n : size - len;
+    memcpy(dst + len, line, copy);
+    len += copy;
+  }
+}
+
+/**
+ * Compression ratio and cost of a payload, and how many events of it fit in
+ * the ring with and without compression
+ */
+static void bench_compress(uint8_t *const ring, const uint8_t *const payload,
+                           const uint32_t size, const char *const name) {
+  uint8_t *const compressed = malloc(event_compress_bound(size));
+  uint8_t *const out = malloc(size);
+  const uint64_t n = iterations(size) / 16 + 1;
+  uint32_t len = 0;
+  uint64_t start = event_clock_monotonic_ns();
+  for (uint64_t i = 0; i < n; i++) {
+    len = event_compress(payload, size, compressed, event_compress_bound(size));
+  }
+  const double compress_ns =
+      (double)(event_clock_monotonic_ns() - start) / (double)n;
+  double decompress_ns = 0;
+  if (len > 0) {
+    start = event_clock_monotonic_ns();
+    for (uint64_t i = 0; i < n; i++) {
+      sink = event_decompress(compressed, len, out, size);
+    }
+    decompress_ns = (double)(event_clock_monotonic_ns() - start) / (double)n;
+  }
+
+  uint32_t fit[2];
+  for (uint32_t threshold = 0; threshold < 2; threshold++) {
+    event_queue_t eq;
+    event_queue_config_t eq_config = {.buffer = ring,
+                                      .buffer_len = BENCH_RING_SIZE,
+                                      .alignment = 8,
+                                      .use_atomics = true,
+                                      .skip_clear = true,
+                                      .compress_threshold = threshold};
+    event_queue_init(&eq, &eq_config);
+    fit[threshold] = 0;
+    while (event_queue_put(&eq, 0, (void *)payload, size)) {
+      fit[threshold]++;
+    }
+  }
+
+  printf("%8u %8s %8.2f %12.0f %12.0f %10u %10u\n", size, name,
+         len ? (double)size / (double)len : 1.0, compress_ns, decompress_ns,
+         fit[0], fit[1]);
+  free(out);
+  free(compressed);
+}
+
+static volatile atomic_int_t bench_lock_word;
+
+static void bench_lock(void) {
+  int expected = 0;
+  while (!atomic_compare_exchange_weak(&bench_lock_word, &expected, 1)) {
+    expected = 0;
+  }
+}
+
+static void bench_unlock(void) { atomic_store(&bench_lock_word, 0); }
+
+/**
+ * Time a locked put of small events, direct or through a staging buffer,
+ * draining the queue whenever the producer finds it full
+ */
+static double bench_staged(uint8_t *const ring, const uint8_t *const src,
+                           const uint32_t size, const uint32_t batch) {
+  event_queue_t eq;
+  event_queue_config_t eq_config = {.buffer = ring,
+                                    .buffer_len = BENCH_RING_SIZE,
+                                    .alignment = 8,
+                                    .use_atomics = true,
+                                    .lock = bench_lock,
+                                    .unlock = bench_unlock};
+  event_queue_init(&eq, &eq_config);
+  event_t events[64];
+  uint8_t data[64 * 64];
+  event_stage_t stage;
+  event_stage_config_t stage_config = {.eq = &eq,
+                                       .events = events,
+                                       .max_events = batch,
+                                       .data = data,
+                                       .data_len = sizeof(data)};
+  event_stage_init(&stage, &stage_config);
+
+  const uint64_t n = iterations(size) * 4;
+  uint32_t checksum = 0;
+  const uint64_t start = event_clock_monotonic_ns();
+  for (uint64_t i = 0; i < n; i++) {
+    const bool placed =
+        (batch > 1) ? event_stage_put(&stage, (event_id_t)i, src, size)
+                    : event_queue_put(&eq, (event_id_t)i, (void *)src, size);
+    if (!placed || stage.count == stage.config.max_events) {
+      event_t *evt;
+      while ((evt = event_queue_get(&eq)) != NULL) {
+        checksum += *(const uint8_t *)evt->event_data;
+        event_queue_pop(&eq);
+      }
+      if (!placed) {
+        i--;
+      }
+    }
+  }
+  event_stage_flush(&stage);
+  const double ns = (double)(event_clock_monotonic_ns() - start) / (double)n;
+  sink = checksum;
+  return ns;
+}
+
+int main(void) {
+  uint8_t *const ring = malloc(BENCH_RING_SIZE);
+  uint8_t *const src = malloc(64 * 1024);
+  memset(ring, 0, BENCH_RING_SIZE);
+  for (uint32_t i = 0; i < 64 * 1024; i++) {
+    src[i] = (uint8_t)i;
+  }
+
+  printf("Small payload copy (ns/copy)\n");
+  printf("%8s %10s %10s\n", "bytes", "memcpy", "inline");
+  const uint32_t small_sizes[] = {4, 8, 12, 16, 24, 32};
+  for (uint32_t i = 0; i < sizeof(small_sizes) / sizeof(small_sizes[0]); i++) {
+    const uint32_t size = small_sizes[i];
+    printf("%8u %10.2f %10.2f\n", size, bench_copy(copy_libc, ring, src, size),
+           bench_copy(copy_small, ring, src, size));
+  }
+
+  printf("\nLarge payload copy (ns/copy)\n");
+  printf("%8s %10s %10s\n", "bytes", "memcpy", "stream");
+  const uint32_t large_sizes[] = {1024, 4096, 16384, 65536};
+  for (uint32_t i = 0; i < sizeof(large_sizes) / sizeof(large_sizes[0]); i++) {
+    const uint32_t size = large_sizes[i];
+    printf("%8u %10.2f %10.2f\n", size, bench_copy(copy_libc, ring, src, size),
+           bench_copy(copy_stream, ring, src, size));
+  }
+
+  const uint32_t hot_set_len = 64 * 1024;
+  uint32_t *const hot_set = calloc(hot_set_len, sizeof(uint32_t));
+  printf("\nLarge payload copy with a %u KB producer hot set (ns/copy)\n",
+         (uint32_t)(hot_set_len * sizeof(uint32_t) / 1024));
+  printf("%8s %10s %10s\n", "bytes", "memcpy", "stream");
+  for (uint32_t i = 0; i < sizeof(large_sizes) / sizeof(large_sizes[0]); i++) {
+    const uint32_t size = large_sizes[i];
+    printf("%8u %10.2f %10.2f\n", size,
+           bench_copy_hot_set(copy_libc, ring, src, size, hot_set, hot_set_len),
+           bench_copy_hot_set(copy_stream, ring, src, size, hot_set,
+                              hot_set_len));
+  }
+  free(hot_set);
+
+  printf("\nPut, get and pop (ns/event)\n");
+  printf("%8s %10s %10s\n", "bytes", "cached", "stream");
+  const uint32_t queue_sizes[] = {16, 256, 4096, 16384, 65536};
+  for (uint32_t i = 0; i < sizeof(queue_sizes) / sizeof(queue_sizes[0]); i++) {
+    const uint32_t size = queue_sizes[i];
+    printf("%8u %10.2f %10.2f\n", size, bench_queue(ring, src, size, 0),
+           bench_queue(ring, src, size, 4096));
+  }
+
+  printf("\nFixed size events, put, get and pop (ns/event)\n");
+  printf("%8s %10s %10s\n", "bytes", "event", "slot");
+  const uint32_t slot_sizes[] = {8, 16, 32, 64};
+  for (uint32_t i = 0; i < sizeof(slot_sizes) / sizeof(slot_sizes[0]); i++) {
+    const uint32_t size = slot_sizes[i];
+    printf("%8u %10.2f %10.2f\n", size,
+           bench_fixed_size(ring, src, size, false),
+           bench_fixed_size(ring, src, size, true));
+  }
+
+  printf("\nLocked put of small events, then get and pop (ns/event)\n");
+  printf("%8s %10s %10s %10s\n", "bytes", "direct", "stage 8", "stage 32");
+  const uint32_t staged_sizes[] = {8, 16, 32, 64};
+  for (uint32_t i = 0; i < sizeof(staged_sizes) / sizeof(staged_sizes[0]);
+       i++) {
+    const uint32_t size = staged_sizes[i];
+    printf("%8u %10.2f %10.2f %10.2f\n", size,
+           bench_staged(ring, src, size, 1), bench_staged(ring, src, size, 8),
+           bench_staged(ring, src, size, 32));
+  }
+
+  printf("\nCompression (ratio, ns/payload, events fitting in a %u KB ring)\n",
+         BENCH_RING_SIZE / 1024);
+  printf("%8s %8s %8s %12s %12s %10s %10s\n", "bytes", "data", "ratio",
+         "compress", "decompress", "raw fit", "lz fit");
+  uint8_t *const telemetry = malloc(64 * 1024);
+  uint8_t *const noise = malloc(64 * 1024);
+  telemetry_payload(telemetry, 64 * 1024);
+  for (uint32_t i = 0; i < 64 * 1024; i++) {
+    noise[i] = (uint8_t)rand();
+  }
+  const uint32_t compress_sizes[] = {256, 1024, 4096, 16384, 65536};
+  for (uint32_t i = 0; i < sizeof(compress_sizes) / sizeof(compress_sizes[0]);
+       i++) {
+    bench_compress(ring, telemetry, compress_sizes[i], "text");
+    bench_compress(ring, noise, compress_sizes[i], "random");
+  }
+  free(noise);
+  free(telemetry);
+
+  free(src);
+  free(ring);
+  return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "block_pool.h"
+
+static void block_pool_lock(block_pool_t *const pool) {
+  int expected = 0;
+  while (!atomic_compare_exchange_weak(&pool->lock, &expected, 1)) {
+    expected = 0;
+  }
+}
+
+static void block_pool_unlock(block_pool_t *const pool) {
+  atomic_store(&pool->lock, 0);
+}
+
+bool block_pool_init(block_pool_t *const pool, void *const buffer,
+                     const uint32_t buffer_len, const uint32_t block_size) {
+  if (buffer == NULL || block_size == 0)
+    return false;
+  pool->buffer = (uint8_t *)buffer;
+  pool->block_size = (block_size + BLOCK_POOL_ALIGNMENT - 1) &
+                     ~(BLOCK_POOL_ALIGNMENT - 1);
+  pool->block_count = buffer_len / pool->block_size;
+  if (pool->block_count == 0)
+    return false;
+
+  // Link every block into the free list
+  for (uint32_t i = 0; i < pool->block_count; i++) {
+    *(uint32_t *)block_pool_block(pool, i) =
+        (i + 1 < pool->block_count) ? i + 1 : BLOCK_POOL_NONE;
+  }
+  pool->free_head = 0;
+  pool->free_count = pool->block_count;
+  atomic_store(&pool->lock, 0);
+  return true;
+}
+
+void *block_pool_alloc(block_pool_t *const pool) {
+  void *block = NULL;
+  block_pool_lock(pool);
+  if (pool->free_head != BLOCK_POOL_NONE) {
+    block = block_pool_block(pool, pool->free_head);
+    pool->free_head = *(uint32_t *)block;
+    pool->free_count--;
+  }
+  block_pool_unlock(pool);
+  return block;
+}
+
+void block_pool_free(block_pool_t *const pool, void *const block) {
+  assert(block_pool_index(pool, block) < pool->block_count);
+  block_pool_lock(pool);
+  *(uint32_t *)block = pool->free_head;
+  pool->free_head = block_pool_index(pool, block);
+  pool->free_count++;
+  block_pool_unlock(pool);
+}
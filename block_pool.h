@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "circular_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define BLOCK_POOL_NONE UINT32_MAX
+#define BLOCK_POOL_ALIGNMENT (uint32_t)8
+
+typedef struct {
+  uint8_t *buffer;            // Pointer to memory
+  uint32_t block_size;        // Size of each block, a multiple of 8
+  uint32_t block_count;       // Number of blocks
+  uint32_t free_head;         // Index of the first free block
+  uint32_t free_count;        // Number of free blocks
+  volatile atomic_int_t lock; // Spin lock protecting the free list
+} block_pool_t;
+
+/**
+ * Initialize a pool of fixed size blocks
+ *
+ *  Free blocks are linked through their first bytes, so the pool needs no
+ *  memory beyond the given buffer. The pool may be shared between threads.
+ *
+ * @param pool Block pool
+ * @param buffer Block of memory to carve into blocks, 8 byte aligned
+ * @param buffer_len Size of the memory block
+ * @param block_size Size of each block, rounded up to a multiple of 8
+ * @return false if the buffer cannot hold a block
+ */
+bool block_pool_init(block_pool_t *const pool, void *const buffer,
+                     const uint32_t buffer_len, const uint32_t block_size);
+
+/**
+ * Take a block from the pool
+ *
+ * @param pool Block pool
+ * @return Pointer to the block, NULL if the pool is empty
+ */
+void *block_pool_alloc(block_pool_t *const pool);
+
+/**
+ * Return a block to the pool
+ *
+ * @param pool Block pool
+ * @param block Block taken from the pool
+ */
+void block_pool_free(block_pool_t *const pool, void *const block);
+
+/**
+ * Get the index of a block
+ *
+ * @param pool Block pool
+ * @param block Block taken from the pool
+ * @return Block index
+ */
+static inline uint32_t block_pool_index(const block_pool_t *const pool,
+                                        const void *const block) {
+  return (uint32_t)(((const uint8_t *)block - pool->buffer) /
+                    pool->block_size);
+}
+
+/**
+ * Get a block by index
+ *
+ * @param pool Block pool
+ * @param index Block index
+ * @return Pointer to the block
+ */
+static inline void *block_pool_block(const block_pool_t *const pool,
+                                     const uint32_t index) {
+  return pool->buffer + (size_t)index * pool->block_size;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // BLOCK_POOL_H
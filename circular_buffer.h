@@ -125,9 +125,6 @@ static inline void circular_buffer_consume(circular_buffer_t *const cb,
     cb->fill_count -= amount;
   }
   assert(cb->fill_count >= 0);
-  if (cb->fill_count > (int)cb->high_water_fill_count) {
-    cb->high_water_fill_count = cb->fill_count;
-  }
 }
 
 /**
@@ -178,6 +175,9 @@ static inline void circular_buffer_produce(circular_buffer_t *const cb,
     cb->fill_count += amount;
   }
   assert(cb->fill_count <= (int)cb->length);
+  if (cb->fill_count > (int)cb->high_water_fill_count) {
+    cb->high_water_fill_count = cb->fill_count;
+  }
 }
 
 /**
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "event_capture.h"
+#include "event_clock.h"
+#include <string.h>
+
+static void write_varint(event_capture_t *const cap, uint64_t value) {
+  uint8_t bytes[10];
+  uint32_t count = 0;
+  do {
+    bytes[count] = (uint8_t)(value & 0x7F);
+    value >>= 7;
+    if (value) {
+      bytes[count] |= 0x80;
+    }
+    count++;
+  } while (value);
+  if (fwrite(bytes, 1, count, cap->file) != count) {
+    cap->error = true;
+  }
+}
+
+static bool read_varint(event_capture_t *const cap, uint64_t *const value,
+                        const bool allow_eof) {
+  *value = 0;
+  for (uint32_t shift = 0; shift < 64; shift += 7) {
+    const int c = fgetc(cap->file);
+    if (c == EOF) {
+      // End of file is only valid before the first byte of a record
+      cap->error = !(allow_eof && shift == 0);
+      return false;
+    }
+    *value |= (uint64_t)(c & 0x7F) << shift;
+    if ((c & 0x80) == 0) {
+      return true;
+    }
+  }
+  cap->error = true;
+  return false;
+}
+
+bool event_capture_open(event_capture_t *const cap, FILE *const file) {
+  cap->file = file;
+  cap->last_time_ns = 0;
+  cap->record_count = 0;
+  cap->error = false;
+  const uint8_t version = EVENT_CAPTURE_VERSION;
+  if (fwrite(EVENT_CAPTURE_MAGIC, 1, 4, file) != 4 ||
+      fwrite(&version, 1, 1, file) != 1) {
+    cap->error = true;
+  }
+  return !cap->error;
+}
+
+void event_capture_write(event_capture_t *const cap, const uint32_t event_id,
+                         const void *const event_data,
+                         const uint32_t event_data_len) {
+  const uint64_t now = event_clock_monotonic_ns();
+  const uint64_t delta =
+      (cap->record_count > 0 && now > cap->last_time_ns)
+          ? now - cap->last_time_ns
+          : 0U;
+  cap->last_time_ns = now;
+  write_varint(cap, delta);
+  write_varint(cap, event_id);
+  write_varint(cap, event_data_len);
+  if (event_data_len > 0 &&
+      fwrite(event_data, 1, event_data_len, cap->file) != event_data_len) {
+    cap->error = true;
+  }
+  cap->record_count++;
+}
+
+bool event_capture_close(event_capture_t *const cap) {
+  if (fflush(cap->file) != 0) {
+    cap->error = true;
+  }
+  return !cap->error;
+}
+
+bool event_capture_open_read(event_capture_t *const cap, FILE *const file) {
+  uint8_t header[5];
+  cap->file = file;
+  cap->last_time_ns = 0;
+  cap->record_count = 0;
+  cap->error = fread(header, 1, sizeof(header), file) != sizeof(header) ||
+               memcmp(header, EVENT_CAPTURE_MAGIC, 4) != 0 ||
+               header[4] != EVENT_CAPTURE_VERSION;
+  return !cap->error;
+}
+
+bool event_capture_read(event_capture_t *const cap,
+                        event_capture_record_t *const record,
+                        void *const event_data,
+                        const uint32_t event_data_capacity) {
+  uint64_t delta, event_id, event_data_len;
+  if (cap->error || !read_varint(cap, &delta, true) ||
+      !read_varint(cap, &event_id, false) ||
+      !read_varint(cap, &event_data_len, false)) {
+    return false;
+  }
+  if (event_id > UINT32_MAX || event_data_len > event_data_capacity) {
+    cap->error = true;
+    return false;
+  }
+  if (event_data_len > 0 &&
+      fread(event_data, 1, event_data_len, cap->file) != event_data_len) {
+    cap->error = true;
+    return false;
+  }
+  record->event_id = (uint32_t)event_id;
+  record->event_data_length = (uint32_t)event_data_len;
+  record->delta_ns = delta;
+  cap->last_time_ns += delta;
+  cap->record_count++;
+  return true;
+}
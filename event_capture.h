@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// Capture files start with EVENT_CAPTURE_MAGIC and a version byte, followed by
+// one record per put: LEB128 encoded inter-arrival time in nanoseconds, event
+// id and data length, then the event data.
+#define EVENT_CAPTURE_MAGIC "EEQC"
+#define EVENT_CAPTURE_VERSION (uint8_t)1
+
+typedef struct {
+  FILE *file;              // Capture stream
+  uint64_t last_time_ns;   // Time of the previous record, 0 before the first
+  uint64_t record_count;   // Number of records written or read
+  bool error;              // An I/O or format error occurred
+} event_capture_t;
+
+typedef struct {
+  uint32_t event_id;          // Event identifier
+  uint32_t event_data_length; // Size of event data
+  uint64_t delta_ns;          // Time since the previous record
+} event_capture_record_t;
+
+/**
+ * Start a capture, writing the file header
+ *
+ * @param cap Capture
+ * @param file Stream opened for binary writing
+ * @return true if the header was written
+ */
+bool event_capture_open(event_capture_t *const cap, FILE *const file);
+
+/**
+ * Append a put to the capture
+ *
+ * @param cap Capture
+ * @param event_id Event identifier
+ * @param event_data Data accompanying the event
+ * @param event_data_len Size of event data
+ */
+void event_capture_write(event_capture_t *const cap, const uint32_t event_id,
+                         const void *const event_data,
+                         const uint32_t event_data_len);
+
+/**
+ * Flush the capture stream
+ *
+ *  The stream is not closed and remains owned by the caller.
+ *
+ * @param cap Capture
+ * @return false if any record failed to write
+ */
+bool event_capture_close(event_capture_t *const cap);
+
+/**
+ * Start reading a capture, validating the file header
+ *
+ * @param cap Capture
+ * @param file Stream opened for binary reading
+ * @return true if the header is valid
+ */
+bool event_capture_open_read(event_capture_t *const cap, FILE *const file);
+
+/**
+ * Read the next record of a capture
+ *
+ * @param cap Capture
+ * @param record On output, the record
+ * @param event_data Buffer for the event data
+ * @param event_data_capacity Size of the event data buffer
+ * @return false at the end of the capture, or on error (cap->error set)
+ */
+bool event_capture_read(event_capture_t *const cap,
+                        event_capture_record_t *const record,
+                        void *const event_data,
+                        const uint32_t event_data_capacity);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // EVENT_CAPTURE_H
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENT_CLOCK_H
+#define EVENT_CLOCK_H
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef enum {
+  EVENT_CLOCK_MONOTONIC = 0, // CLOCK_MONOTONIC_RAW, in nanoseconds
+  EVENT_CLOCK_CYCLES,        // rdtsc / cntvct_el0, in counter ticks
+} event_clock_source_t;
+
+/**
+ * Read the monotonic clock
+ *
+ * @return Nanoseconds since an unspecified starting point
+ */
+static inline uint64_t event_clock_monotonic_ns(void) {
+#if defined(_WIN32)
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000ULL +
+         (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000ULL /
+             (uint64_t)frequency.QuadPart;
+#else
+  struct timespec ts;
+#if defined(CLOCK_MONOTONIC_RAW)
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * Read the CPU cycle counter
+ *
+ *  Falls back to the monotonic clock on targets without a user readable
+ *  counter.
+ *
+ * @return Counter ticks since an unspecified starting point
+ */
+static inline uint64_t event_clock_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t ticks;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#else
+  return event_clock_monotonic_ns();
+#endif
+}
+
+/**
+ * Read the given clock source
+ *
+ * @param source Clock source
+ * @return Current time in the units of the clock source
+ */
+static inline uint64_t event_clock_now(const event_clock_source_t source) {
+  if (source == EVENT_CLOCK_CYCLES) {
+    return event_clock_cycles();
+  }
+  return event_clock_monotonic_ns();
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // EVENT_CLOCK_H
@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "event_compress.h"
+
+#include <stdbool.h>
+
+static inline uint32_t event_compress_read32(const uint8_t *const p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline uint32_t event_compress_hash(const uint32_t value,
+                                           const uint32_t bits) {
+  return (value * 2654435761U) >> (32 - bits);
+}
+
+// Write the part of a length that does not fit in a token nibble
+static inline uint8_t *event_compress_length(uint8_t *op, uint32_t len) {
+  for (; len >= 255; len -= 255) {
+    *op++ = 255;
+  }
+  *op++ = (uint8_t)len;
+  return op;
+}
+
+uint32_t event_compress(const void *const src, const uint32_t len,
+                        void *const dst, const uint32_t dst_len) {
+  const uint8_t *const in = (const uint8_t *)src;
+  uint8_t *const out = (uint8_t *)dst;
+  // Compressed output is only kept when smaller than the payload
+  const uint32_t limit = (dst_len < len) ? dst_len : len - (len > 0);
+  // Small payloads only clear as much of the table as they can use
+  uint32_t bits = 6;
+  while (bits < EVENT_COMPRESS_HASH_BITS && (1U << bits) < len) {
+    bits++;
+  }
+  uint32_t table[1U << EVENT_COMPRESS_HASH_BITS];
+  memset(table, 0xFF, sizeof(uint32_t) << bits);
+
+  uint32_t ip = 0;
+  uint32_t anchor = 0;
+  uint32_t op = 0;
+  uint32_t misses = 0;
+  while (len >= EVENT_COMPRESS_MIN_MATCH &&
+         ip <= len - EVENT_COMPRESS_MIN_MATCH) {
+    const uint32_t value = event_compress_read32(in + ip);
+    const uint32_t h = event_compress_hash(value, bits);
+    const uint32_t candidate = table[h];
+    table[h] = ip;
+    if (candidate == UINT32_MAX || ip - candidate > EVENT_COMPRESS_MAX_OFFSET ||
+        event_compress_read32(in + candidate) != value) {
+      // Step further the longer nothing matches, skipping incompressible data
+      ip += 1 + (misses++ >> 5);
+      continue;
+    }
+    misses = 0;
+
+    // Extend the match
+    uint32_t match_len = EVENT_COMPRESS_MIN_MATCH;
+    while (ip + match_len < len &&
+           in[candidate + match_len] == in[ip + match_len]) {
+      match_len++;
+    }
+
+    // Token, literals, offset and lengths, checked against the limit first
+    const uint32_t literal_len = ip - anchor;
+    const uint32_t needed = 1 + literal_len + literal_len / 255 + 1 + 2 +
+                            (match_len - EVENT_COMPRESS_MIN_MATCH) / 255 + 1;
+    if (op + needed > limit) {
+      return 0;
+    }
+    const uint32_t match_code = match_len - EVENT_COMPRESS_MIN_MATCH;
+    uint8_t *p = out + op;
+    uint8_t *const token = p++;
+    *token = (uint8_t)(((literal_len < 15) ? literal_len : 15) << 4 |
+                       ((match_code < 15) ? match_code : 15));
+    if (literal_len >= 15) {
+      p = event_compress_length(p, literal_len - 15);
+    }
+    memcpy(p, in + anchor, literal_len);
+    p += literal_len;
+    const uint32_t offset = ip - candidate;
+    *p++ = (uint8_t)offset;
+    *p++ = (uint8_t)(offset >> 8);
+    if (match_code >= 15) {
+      p = event_compress_length(p, match_code - 15);
+    }
+    op = (uint32_t)(p - out);
+
+    ip += match_len;
+    anchor = ip;
+  }
+
+  // Trailing literals
+  const uint32_t literal_len = len - anchor;
+  if (op + 1 + literal_len + literal_len / 255 + 1 > limit) {
+    return 0;
+  }
+  uint8_t *p = out + op;
+  *p++ = (uint8_t)(((literal_len < 15) ? literal_len : 15) << 4);
+  if (literal_len >= 15) {
+    p = event_compress_length(p, literal_len - 15);
+  }
+  memcpy(p, in + anchor, literal_len);
+  p += literal_len;
+  return (uint32_t)(p - out);
+}
+
+// Read the part of a length that did not fit in a token nibble
+static inline bool event_decompress_length(const uint8_t **ip,
+                                           const uint8_t *const end,
+                                           uint32_t *const len) {
+  uint8_t byte;
+  do {
+    if (*ip == end) {
+      return false;
+    }
+    byte = *(*ip)++;
+    *len += byte;
+  } while (byte == 255);
+  return true;
+}
+
+uint32_t event_decompress(const void *const src, const uint32_t len,
+                          void *const dst, const uint32_t dst_len) {
+  const uint8_t *ip = (const uint8_t *)src;
+  const uint8_t *const end = ip + len;
+  uint8_t *const out = (uint8_t *)dst;
+  uint32_t op = 0;
+
+  while (ip < end) {
+    const uint8_t token = *ip++;
+    uint32_t literal_len = token >> 4;
+    if (literal_len == 15 && !event_decompress_length(&ip, end, &literal_len)) {
+      return 0;
+    }
+    if (literal_len > (uint32_t)(end - ip) || literal_len > dst_len - op) {
+      return 0;
+    }
+    memcpy(out + op, ip, literal_len);
+    ip += literal_len;
+    op += literal_len;
+    if (ip == end) {
+      break;
+    }
+
+    if (end - ip < 2) {
+      return 0;
+    }
+    const uint32_t offset = (uint32_t)ip[0] | (uint32_t)ip[1] << 8;
+    ip += 2;
+    uint32_t match_len = token & 15;
+    if (match_len == 15 && !event_decompress_length(&ip, end, &match_len)) {
+      return 0;
+    }
+    match_len += EVENT_COMPRESS_MIN_MATCH;
+    if (offset == 0 || offset > op || match_len > dst_len - op) {
+      return 0;
+    }
+    // Matches may overlap their own output
+    const uint8_t *match = out + op - offset;
+    if (offset >= match_len) {
+      memcpy(out + op, match, match_len);
+    } else {
+      for (uint32_t i = 0; i < match_len; i++) {
+        out[op + i] = match[i];
+      }
+    }
+    op += match_len;
+  }
+  return op;
+}
@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENT_COMPRESS_H
+#define EVENT_COMPRESS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// Matches are found through a hash table of this many recent positions
+#define EVENT_COMPRESS_HASH_BITS 12
+#define EVENT_COMPRESS_MIN_MATCH (uint32_t)4
+#define EVENT_COMPRESS_MAX_OFFSET (uint32_t)65535
+
+/**
+ * Largest compressed size of an input
+ *
+ * @param len Size of the input
+ * @return Size the output buffer needs
+ */
+static inline uint32_t event_compress_bound(const uint32_t len) {
+  return len + len / 255 + 16;
+}
+
+/**
+ * Compress a payload with a byte oriented LZ77 codec
+ *
+ *  Each sequence is a token holding literal and match lengths, the literals,
+ *  then a 16 bit match offset. Lengths that do not fit the token continue in
+ *  bytes of 255. The last sequence has literals only.
+ *
+ * @param src Payload
+ * @param len Size of the payload
+ * @param dst Compressed output
+ * @param dst_len Size of the output buffer
+ * @return Compressed size, 0 if it would not be smaller than the payload
+ */
+uint32_t event_compress(const void *const src, const uint32_t len,
+                        void *const dst, const uint32_t dst_len);
+
+/**
+ * Decompress a payload compressed by event_compress
+ *
+ * @param src Compressed payload
+ * @param len Size of the compressed payload
+ * @param dst Output
+ * @param dst_len Size of the output buffer
+ * @return Decompressed size, 0 if the input is corrupt or the output too small
+ */
+uint32_t event_decompress(const void *const src, const uint32_t len,
+                          void *const dst, const uint32_t dst_len);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // EVENT_COMPRESS_H
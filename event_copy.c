@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "event_copy.h"
+
+// Shorter copies are not worth aligning for streaming stores
+#define EVENT_COPY_STREAM_MIN (uint32_t)256
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// Copies the unaligned head with a regular copy, streams the aligned body,
+// then copies the tail
+#define EVENT_COPY_STREAM_BODY(width, load, store)                             \
+  uint8_t *d = (uint8_t *)dst;                                                 \
+  const uint8_t *s = (const uint8_t *)src;                                     \
+  uint32_t remaining = len;                                                    \
+  const uint32_t head = (uint32_t)(-(uintptr_t)d & ((width)-1));               \
+  memcpy(d, s, head);                                                          \
+  d += head;                                                                   \
+  s += head;                                                                   \
+  remaining -= head;                                                           \
+  while (remaining >= 4 * (width)) {                                           \
+    store(d, load(s));                                                         \
+    store(d + (width), load(s + (width)));                                     \
+    store(d + 2 * (width), load(s + 2 * (width)));                             \
+    store(d + 3 * (width), load(s + 3 * (width)));                             \
+    d += 4 * (width);                                                          \
+    s += 4 * (width);                                                          \
+    remaining -= 4 * (width);                                                  \
+  }                                                                            \
+  while (remaining >= (width)) {                                               \
+    store(d, load(s));                                                         \
+    d += (width);                                                              \
+    s += (width);                                                              \
+    remaining -= (width);                                                      \
+  }                                                                            \
+  memcpy(d, s, remaining);                                                     \
+  _mm_sfence();
+
+#define SSE2_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#define SSE2_STREAM(p, v) _mm_stream_si128((__m128i *)(p), v)
+#define AVX2_LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+#define AVX2_STREAM(p, v) _mm256_stream_si256((__m256i *)(p), v)
+
+static void event_copy_stream_sse2(void *const dst, const void *const src,
+                                   const uint32_t len) {
+  EVENT_COPY_STREAM_BODY(16, SSE2_LOAD, SSE2_STREAM)
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2"))) static void
+event_copy_stream_avx2(void *const dst, const void *const src,
+                       const uint32_t len) {
+  EVENT_COPY_STREAM_BODY(32, AVX2_LOAD, AVX2_STREAM)
+}
+#endif
+
+void event_copy_stream(void *const dst, const void *const src,
+                       const uint32_t len) {
+  if (len < EVENT_COPY_STREAM_MIN) {
+    memcpy(dst, src, len);
+    return;
+  }
+#if defined(__GNUC__) || defined(__clang__)
+  if (__builtin_cpu_supports("avx2")) {
+    event_copy_stream_avx2(dst, src, len);
+    return;
+  }
+#endif
+  event_copy_stream_sse2(dst, src, len);
+}
+
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+
+void event_copy_stream(void *const dst, const void *const src,
+                       const uint32_t len) {
+  uint8_t *d = (uint8_t *)dst;
+  const uint8_t *s = (const uint8_t *)src;
+  uint32_t remaining = len;
+  // STNP hints the stores as non-temporal
+  while (remaining >= 32) {
+    const uint8x16_t a = vld1q_u8(s);
+    const uint8x16_t b = vld1q_u8(s + 16);
+    __asm__ __volatile__("stnp %q0, %q1, [%2]" ::"w"(a), "w"(b), "r"(d)
+                         : "memory");
+    d += 32;
+    s += 32;
+    remaining -= 32;
+  }
+  memcpy(d, s, remaining);
+  __asm__ __volatile__("dmb ishst" ::: "memory");
+}
+
+#else
+
+void event_copy_stream(void *const dst, const void *const src,
+                       const uint32_t len) {
+  memcpy(dst, src, len);
+}
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENT_COPY_H
+#define EVENT_COPY_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// Payloads up to this size are copied inline with overlapping fixed width
+// moves instead of calling into libc
+#define EVENT_COPY_SMALL_MAX (uint32_t)32
+
+// Cache lines prefetched ahead of reading a streamed payload
+#define EVENT_COPY_PREFETCH_LINES (uint32_t)8
+#define EVENT_COPY_CACHE_LINE (uint32_t)64
+
+/**
+ * Copy a payload of at most EVENT_COPY_SMALL_MAX bytes
+ *
+ * @param dst Destination
+ * @param src Source
+ * @param len Number of bytes, at most EVENT_COPY_SMALL_MAX
+ */
+static inline void event_copy_small(void *const dst, const void *const src,
+                                    const uint32_t len) {
+  uint8_t *const d = (uint8_t *)dst;
+  const uint8_t *const s = (const uint8_t *)src;
+  // Each case copies the head and tail of the range, overlapping in the middle
+  if (len >= 16) {
+    uint64_t a, b, c, e;
+    memcpy(&a, s, 8);
+    memcpy(&b, s + 8, 8);
+    memcpy(&c, s + len - 16, 8);
+    memcpy(&e, s + len - 8, 8);
+    memcpy(d, &a, 8);
+    memcpy(d + 8, &b, 8);
+    memcpy(d + len - 16, &c, 8);
+    memcpy(d + len - 8, &e, 8);
+  } else if (len >= 8) {
+    uint64_t a, b;
+    memcpy(&a, s, 8);
+    memcpy(&b, s + len - 8, 8);
+    memcpy(d, &a, 8);
+    memcpy(d + len - 8, &b, 8);
+  } else if (len >= 4) {
+    uint32_t a, b;
+    memcpy(&a, s, 4);
+    memcpy(&b, s + len - 4, 4);
+    memcpy(d, &a, 4);
+    memcpy(d + len - 4, &b, 4);
+  } else if (len > 0) {
+    d[0] = s[0];
+    d[len / 2] = s[len / 2];
+    d[len - 1] = s[len - 1];
+  }
+}
+
+/**
+ * Copy a payload with non-temporal stores
+ *
+ *  The stores bypass the cache of the caller, for data only another core will
+ *  read. Falls back to SIMD copies on targets without streaming stores.
+ *
+ * @param dst Destination
+ * @param src Source
+ * @param len Number of bytes
+ */
+void event_copy_stream(void *const dst, const void *const src,
+                       const uint32_t len);
+
+/**
+ * Copy a payload, choosing the strategy by size
+ *
+ * @param dst Destination
+ * @param src Source
+ * @param len Number of bytes
+ * @param stream_threshold Size from which non-temporal stores are used,
+ * 0 to never use them
+ */
+static inline void event_copy(void *const dst, const void *const src,
+                              const uint32_t len,
+                              const uint32_t stream_threshold) {
+  if (len <= EVENT_COPY_SMALL_MAX) {
+    event_copy_small(dst, src, len);
+  } else if (stream_threshold == 0 || len < stream_threshold) {
+    memcpy(dst, src, len);
+  } else {
+    event_copy_stream(dst, src, len);
+  }
+}
+
+/**
+ * Hint that a payload is about to be read
+ *
+ * @param data Payload
+ * @param len Number of bytes
+ */
+static inline void event_copy_prefetch(const void *const data,
+                                       const uint32_t len) {
+#if defined(__GNUC__) || defined(__clang__)
+  const uint8_t *const p = (const uint8_t *)data;
+  for (uint32_t i = 0;
+       i < EVENT_COPY_PREFETCH_LINES && i * EVENT_COPY_CACHE_LINE < len; i++) {
+    __builtin_prefetch(p + i * EVENT_COPY_CACHE_LINE, 0, 0);
+  }
+#else
+  (void)data;
+  (void)len;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // EVENT_COPY_H
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "event_filter.h"
+#include <string.h>
+
+void event_filter_init(event_filter_t *const filter, uint64_t *const bitmap,
+                       const uint32_t bitmap_words, uint32_t *const ids,
+                       const uint32_t id_capacity) {
+  filter->bitmap = bitmap;
+  filter->bitmap_bits = bitmap ? bitmap_words * 64 : 0;
+  filter->ids = ids;
+  filter->id_count = 0;
+  filter->id_capacity = ids ? id_capacity : 0;
+  if (bitmap) {
+    memset(bitmap, 0, bitmap_words * sizeof(uint64_t));
+  }
+}
+
+bool event_filter_add(event_filter_t *const filter, const uint32_t event_id) {
+  if (event_id < filter->bitmap_bits) {
+    filter->bitmap[event_id / 64] |= 1ULL << (event_id % 64);
+    return true;
+  }
+  const uint32_t i = event_filter_lower_bound(filter, event_id);
+  if (i < filter->id_count && filter->ids[i] == event_id) {
+    return true;
+  }
+  if (filter->id_count == filter->id_capacity) {
+    return false;
+  }
+  memmove(&filter->ids[i + 1], &filter->ids[i],
+          (filter->id_count - i) * sizeof(uint32_t));
+  filter->ids[i] = event_id;
+  filter->id_count++;
+  return true;
+}
+
+void event_filter_remove(event_filter_t *const filter,
+                         const uint32_t event_id) {
+  if (event_id < filter->bitmap_bits) {
+    filter->bitmap[event_id / 64] &= ~(1ULL << (event_id % 64));
+    return;
+  }
+  const uint32_t i = event_filter_lower_bound(filter, event_id);
+  if (i < filter->id_count && filter->ids[i] == event_id) {
+    memmove(&filter->ids[i], &filter->ids[i + 1],
+            (filter->id_count - i - 1) * sizeof(uint32_t));
+    filter->id_count--;
+  }
+}
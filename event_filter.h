@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENT_FILTER_H
+#define EVENT_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef struct {
+  uint64_t *bitmap;     // One bit per id below bitmap_bits
+  uint32_t bitmap_bits; // Number of ids covered by the bitmap
+  uint32_t *ids;        // Sorted ids from bitmap_bits up
+  uint32_t id_count;    // Number of ids in the set
+  uint32_t id_capacity; // Size of the id set storage
+} event_filter_t;
+
+/**
+ * Initialize an empty event id filter
+ *
+ *  Small ids are held in a bitmap, larger ids in a sorted set. Either storage
+ *  may be omitted.
+ *
+ * @param filter Event filter
+ * @param bitmap Bitmap storage, or NULL
+ * @param bitmap_words Number of 64 bit words of bitmap storage
+ * @param ids Id set storage, or NULL
+ * @param id_capacity Number of ids the set storage holds
+ */
+void event_filter_init(event_filter_t *const filter, uint64_t *const bitmap,
+                       const uint32_t bitmap_words, uint32_t *const ids,
+                       const uint32_t id_capacity);
+
+/**
+ * Add an event id to the filter
+ *
+ * @param filter Event filter
+ * @param event_id Event identifier
+ * @return false if the id set is full
+ */
+bool event_filter_add(event_filter_t *const filter, const uint32_t event_id);
+
+/**
+ * Remove an event id from the filter
+ *
+ * @param filter Event filter
+ * @param event_id Event identifier
+ */
+void event_filter_remove(event_filter_t *const filter,
+                         const uint32_t event_id);
+
+/**
+ * Get the position of an id in the id set
+ *
+ * @param filter Event filter
+ * @param event_id Event identifier, at least bitmap_bits
+ * @return Index of the first id not less than event_id
+ */
+static inline uint32_t
+event_filter_lower_bound(const event_filter_t *const filter,
+                         const uint32_t event_id) {
+  uint32_t low = 0;
+  uint32_t high = filter->id_count;
+  while (low < high) {
+    const uint32_t mid = low + (high - low) / 2;
+    if (filter->ids[mid] < event_id) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * Check if the filter matches an event id
+ *
+ * @param filter Event filter
+ * @param event_id Event identifier
+ * @return true if the id was added to the filter
+ */
+static inline bool event_filter_match(const event_filter_t *const filter,
+                                      const uint32_t event_id) {
+  if (event_id < filter->bitmap_bits) {
+    return (filter->bitmap[event_id / 64] >> (event_id % 64)) & 1U;
+  }
+  const uint32_t i = event_filter_lower_bound(filter, event_id);
+  return i < filter->id_count && filter->ids[i] == event_id;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // EVENT_FILTER_H
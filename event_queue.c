@@ -20,45 +20,100 @@
  * SOFTWARE.
  */
 #include "event_queue.h"
+#include "event_compress.h"
+#include "event_queue_trace.h"
 #include <stdlib.h>
 
-bool event_queue_init(event_queue_t *const eq,
-                      event_queue_config_t *const config) {
-  if (config->buffer == NULL)
-    return false;
-  if (config->buffer_len == 0)
-    return false;
-  memcpy(&eq->config, config, sizeof(event_queue_config_t));
-  memset(config->buffer, 0, config->buffer_len);
-  circular_buffer_init(&eq->_cb, config->buffer, config->buffer_len,
-                       config->use_atomics);
-  return true;
+static inline uint32_t event_marker(const uint32_t flags) {
+  return EVENT_MARKER & ~(flags << 8);
 }
 
-void event_queue_clear(event_queue_t *const eq) {
-  circular_buffer_clear(&eq->_cb);
+static inline uint32_t event_flags(const uint32_t marker) {
+  return (~marker >> 8) & 0xFF;
 }
 
-bool event_queue_put(event_queue_t *const eq, const event_id_t event_id,
-                     void *const event_data, const uint32_t event_data_len) {
-  // If locking function present, lock
-  if (eq->config.lock) {
-    eq->config.lock();
+// Size of the optional fields stored between event_t and the event data
+static inline uint32_t event_ext_size(const uint32_t flags) {
+  return ((flags & EVENT_FLAG_TIMESTAMP) ? sizeof(uint64_t) : 0U) +
+         ((flags & EVENT_FLAG_EXPIRY) ? sizeof(uint64_t) : 0U) +
+         ((flags & EVENT_FLAG_COMPRESSED) ? sizeof(uint64_t) : 0U);
+}
+
+// Expiry time of an event with EVENT_FLAG_EXPIRY, stored after the timestamp
+static inline uint64_t event_expiry(const event_t *const evt,
+                                    const uint32_t flags) {
+  uint64_t expiry;
+  memcpy(&expiry,
+         (const uint8_t *)(evt + 1) +
+             ((flags & EVENT_FLAG_TIMESTAMP) ? sizeof(uint64_t) : 0U),
+         sizeof(expiry));
+  return expiry;
+}
+
+// Size of the event data stored in the buffer
+static inline uint32_t event_ring_data_length(const event_t *const evt,
+                                              const uint32_t flags) {
+  return (flags & EVENT_FLAG_SHARED) ? (uint32_t)sizeof(void *)
+                                     : evt->event_data_length;
+}
+
+// Drop the payload reference held by an event with EVENT_FLAG_SHARED
+static inline void event_release_shared(const event_t *const evt,
+                                        const uint32_t flags) {
+  if (flags & EVENT_FLAG_SHARED) {
+    payload_release(evt->event_data);
   }
+}
+
+// Flags of events placed by event_queue_put
+static inline uint32_t event_queue_put_flags(const event_queue_t *const eq) {
+  return eq->config.latency_histogram ? EVENT_FLAG_TIMESTAMP : 0U;
+}
+
+// Check if event_queue_put compresses data of a size
+static inline bool event_queue_compresses(const event_queue_t *const eq,
+                                          const uint32_t event_data_len) {
+  return eq->config.compress_threshold &&
+         event_data_len >= eq->config.compress_threshold;
+}
+
+static inline uint32_t event_queue_padding(const event_queue_t *const eq,
+                                           const uint32_t q_item_size) {
+  const uint32_t alignment = eq->config.alignment;
+  return (alignment > 0)
+             ? (alignment - (q_item_size % alignment)) % alignment
+             : 0U;
+}
+
+// Size of an event record including alignment padding
+static inline uint32_t event_queue_record_size(const event_queue_t *const eq,
+                                               const event_t *const evt,
+                                               const uint32_t flags) {
+  const uint32_t size = sizeof(EVENT_MARKER) + sizeof(event_t) +
+                        event_ext_size(flags) +
+                        event_ring_data_length(evt, flags);
+  return size + event_queue_padding(eq, size);
+}
 
+/**
+ * Reserve contiguous space at the head of the buffer
+ *
+ *  Wraps the head to the start of the buffer with padding when there is enough
+ *  free space, but not enough contiguous free space.
+ *
+ * @param eq Event Queue
+ * @param q_item_size Number of contiguous bytes required
+ * @return Pointer to the reserved space, NULL if there is no space
+ */
+static uint8_t *event_queue_reserve(event_queue_t *const eq,
+                                    const uint32_t q_item_size) {
   // Get head point and amount of available free space
   uint32_t avail_space;
   void *head_ptr = circular_buffer_head(&eq->_cb, &avail_space);
 
-  uint32_t q_item_size =
-      sizeof(event_t) + event_data_len + sizeof(EVENT_MARKER);
-  const uint32_t padding =
-      (eq->config.alignment > 0) ? (eq->config.alignment - (q_item_size % eq->config.alignment)) % eq->config.alignment : 0U;
-  q_item_size += padding;
-
   // No space
   if (avail_space < q_item_size)
-    return false;
+    return NULL;
 
   // Check for contiguous space
   const uint32_t avail_contig_space =
@@ -68,87 +123,783 @@ bool event_queue_put(event_queue_t *const eq, const event_id_t event_id,
   if (avail_contig_space < q_item_size) {
     if (avail_space - avail_contig_space < q_item_size) {
       // There is not enough contiguous space
-      return false;
+      return NULL;
     } else {
       // There is enough space, but not enough contiguous space.
       // Add padding to wrap the head to the start of the buffer
       // to create more contiguous space.
       memset(head_ptr, PADDING, avail_contig_space);
       circular_buffer_produce(&eq->_cb, avail_contig_space);
+      EEQ_TRACE_WRAP(eq, avail_contig_space, eq->_cb.fill_count);
       head_ptr = circular_buffer_head(&eq->_cb, &avail_space);
     }
   }
+  return (uint8_t *)head_ptr;
+}
+
+/**
+ * Encode an event record at reserved space in the buffer
+ *
+ *  With EVENT_FLAG_SHARED the event data is a shared payload, only its pointer
+ *  is written and a reference is taken.
+ *
+ * @param eq Event Queue
+ * @param head_ptr Reserved space, q_item_size bytes
+ * @param q_item_size Size of the record including padding
+ * @param flags Event flags
+ * @param ext Optional field values, event_ext_size(flags) bytes
+ * @param event_id Event identifier
+ * @param event_data Data to accompany event
+ * @param event_data_len Size of event data
+ */
+static void event_queue_encode(event_queue_t *const eq, uint8_t *head_ptr,
+                               const uint32_t q_item_size, const uint32_t flags,
+                               const void *const ext, const event_id_t event_id,
+                               const void *const event_data,
+                               const uint32_t event_data_len) {
+  const uint32_t ext_size = event_ext_size(flags);
+  const uint32_t ring_data_len =
+      (flags & EVENT_FLAG_SHARED) ? (uint32_t)sizeof(void *) : event_data_len;
+  const uint32_t padding = q_item_size - (sizeof(EVENT_MARKER) +
+                                          sizeof(event_t) + ext_size +
+                                          ring_data_len);
 
-  // Place start of event marker and event and produce it ready for reading
-  *(uint32_t *)head_ptr = EVENT_MARKER;
-#ifdef _MSC_VER
-  ((uint32_t *)head_ptr) += sizeof(EVENT_MARKER);
-#else
+  // Place start of event marker and event
+  *(uint32_t *)head_ptr = event_marker(flags);
   head_ptr += sizeof(EVENT_MARKER);
-#endif
 
   event_t *event_ptr = (event_t *)head_ptr;
-#ifdef _MSC_VER
-  ((uint32_t *)head_ptr) += sizeof(event_t);
-#else
   head_ptr += sizeof(event_t);
-#endif
+
+  if (ext_size) {
+    memcpy(head_ptr, ext, ext_size);
+    head_ptr += ext_size;
+  }
 
   event_ptr->event_id = event_id;
   event_ptr->event_data_length = event_data_len;
-  event_ptr->event_data = head_ptr;
-  memcpy(head_ptr, event_data, event_data_len);
+  if (flags & EVENT_FLAG_SHARED) {
+    // Reference taken before the consumer can see the event and drop it
+    payload_ref(event_data);
+    memcpy(head_ptr, &event_data, sizeof(void *));
+    event_ptr->event_data = (void *)event_data;
+  } else {
+    event_ptr->event_data = head_ptr;
+    event_copy(head_ptr, event_data, event_data_len,
+               eq->config.copy_stream_threshold);
+  }
   if (padding) {
-#ifdef _MSC_VER
-    ((uint32_t *)head_ptr) += event_data_len;
-#else
-    head_ptr += event_data_len;
-#endif
+    head_ptr += ring_data_len;
     memset(head_ptr, PADDING, padding);
   }
+}
+
+// Size of the record of an event placed in the buffer, including padding
+static inline uint32_t event_queue_item_size(const event_queue_t *const eq,
+                                             const uint32_t flags,
+                                             const uint32_t event_data_len) {
+  const uint32_t ring_data_len =
+      (flags & EVENT_FLAG_SHARED) ? (uint32_t)sizeof(void *) : event_data_len;
+  const uint32_t size = sizeof(EVENT_MARKER) + sizeof(event_t) +
+                        event_ext_size(flags) + ring_data_len;
+  return size + event_queue_padding(eq, size);
+}
+
+// Trace why an event could not be reserved
+static inline void event_queue_reject(event_queue_t *const eq,
+                                      const uint32_t q_item_size,
+                                      const event_id_t event_id,
+                                      const uint32_t event_data_len) {
+  uint32_t avail_space;
+  circular_buffer_head(&eq->_cb, &avail_space);
+  if (avail_space < q_item_size) {
+    EEQ_TRACE_REJECT_FULL(eq, event_id, event_data_len, eq->_cb.fill_count);
+  } else {
+    EEQ_TRACE_REJECT_FRAGMENTED(eq, event_id, event_data_len,
+                                eq->_cb.fill_count);
+  }
+  (void)event_id;
+  (void)event_data_len;
+}
+
+/**
+ * Write an event with optional fields into the buffer and produce it
+ *
+ * @param eq Event Queue
+ * @param flags Event flags
+ * @param ext Optional field values, event_ext_size(flags) bytes
+ * @param event_id Event identifier
+ * @param event_data Data to accompany event
+ * @param event_data_len Size of event data
+ * @return true if the event was placed
+ */
+static bool event_queue_write(event_queue_t *const eq, const uint32_t flags,
+                              const void *const ext, const event_id_t event_id,
+                              const void *const event_data,
+                              const uint32_t event_data_len) {
+  const uint32_t q_item_size =
+      event_queue_item_size(eq, flags, event_data_len);
+
+  uint8_t *head_ptr = event_queue_reserve(eq, q_item_size);
+  if (head_ptr == NULL) {
+    event_queue_reject(eq, q_item_size, event_id, event_data_len);
+    return false;
+  }
+
+  // Encode the event and produce it ready for reading
+  event_queue_encode(eq, head_ptr, q_item_size, flags, ext, event_id,
+                     event_data, event_data_len);
+  circular_buffer_produce(&eq->_cb, q_item_size);
+  EEQ_TRACE_PUT(eq, event_id, event_data_len, eq->_cb.fill_count);
+  return true;
+}
+
+/**
+ * Compress an event into the buffer and produce it
+ *
+ *  Space for the largest compressed size is reserved and the data compressed
+ *  in place, only the bytes used are produced. Data that does not compress is
+ *  stored as is, with a stored length equal to the original length.
+ *
+ * @param eq Event Queue
+ * @param flags Event flags, including EVENT_FLAG_COMPRESSED
+ * @param ext Optional field values, event_ext_size(flags) bytes
+ * @param event_id Event identifier
+ * @param event_data Data to accompany event
+ * @param event_data_len Size of event data
+ * @return true if the event was placed
+ */
+static bool event_queue_write_compressed(event_queue_t *const eq,
+                                         const uint32_t flags,
+                                         const void *const ext,
+                                         const event_id_t event_id,
+                                         const void *const event_data,
+                                         const uint32_t event_data_len) {
+  const uint32_t bound = event_compress_bound(event_data_len);
+  const uint32_t max_item_size = event_queue_item_size(eq, flags, bound);
+  uint8_t *const head_ptr = event_queue_reserve(eq, max_item_size);
+  if (head_ptr == NULL) {
+    event_queue_reject(eq, max_item_size, event_id, event_data_len);
+    return false;
+  }
+
+  const uint32_t ext_size = event_ext_size(flags);
+  uint8_t *const data_ptr =
+      head_ptr + sizeof(EVENT_MARKER) + sizeof(event_t) + ext_size;
+  uint32_t stored_len = event_compress(event_data, event_data_len, data_ptr,
+                                       bound);
+  if (stored_len == 0) {
+    event_copy(data_ptr, event_data, event_data_len,
+               eq->config.copy_stream_threshold);
+    stored_len = event_data_len;
+  }
+
+  // Place the marker, event and optional fields in front of the data
+  *(uint32_t *)head_ptr = event_marker(flags);
+  event_t *const event_ptr = (event_t *)(head_ptr + sizeof(EVENT_MARKER));
+  event_ptr->event_id = event_id;
+  event_ptr->event_data_length = stored_len;
+  event_ptr->event_data = data_ptr;
+  memcpy(event_ptr + 1, ext, ext_size);
+  const uint32_t q_item_size = event_queue_item_size(eq, flags, stored_len);
+  memset(data_ptr + stored_len, PADDING,
+         (uint32_t)(head_ptr + q_item_size - (data_ptr + stored_len)));
 
   circular_buffer_produce(&eq->_cb, q_item_size);
+  EEQ_TRACE_PUT(eq, event_id, stored_len, eq->_cb.fill_count);
+  return true;
+}
+
+/**
+ * Wake parked producers if enough space has been freed for them
+ *
+ * @param eq Event Queue
+ */
+static inline void event_queue_notify_space(event_queue_t *const eq) {
+  const int needed = atomic_load(&eq->_space_needed);
+  if (needed != 0 &&
+      eq->_cb.length - (uint32_t)eq->_cb.fill_count >= (uint32_t)needed) {
+    atomic_store(&eq->_space_needed, 0);
+    atomicFetchAdd(&eq->_space_seq, 1);
+    event_wait_wake(&eq->_space_seq);
+  }
+}
+
+/**
+ * Get the event at the tail of the buffer
+ *
+ *  Padding, events not matching the consumer filter and expired events are
+ *  skipped and consumed together.
+ *
+ * @param eq Event Queue
+ * @param marker On output, the marker of the event
+ * @param drop_expired Skip events past their expiry time
+ * @return Pointer to the event - NULL if no event
+ */
+static event_t *event_queue_peek(event_queue_t *const eq,
+                                 uint32_t *const marker,
+                                 const bool drop_expired) {
+  uint32_t available_bytes;
+  uint8_t *tail = (uint8_t *)circular_buffer_tail(&eq->_cb, &available_bytes);
+  uint8_t *const start = (uint8_t *)eq->_cb.buffer;
+  uint8_t *const end = start + eq->_cb.length;
+  uint32_t skip_bytes = 0;
+  uint64_t now = 0;
+  event_t *evt = NULL;
+
+  while (available_bytes > 0) {
+    if (*tail == PADDING) {
+      tail++;
+      skip_bytes++;
+      available_bytes--;
+    } else {
+      // If there are bytes, it should be at least the size of an base event
+      assert(available_bytes >= sizeof(event_t) + sizeof(EVENT_MARKER));
+
+      // Provide pointer past the event marker
+      *marker = *(uint32_t *)tail;
+      evt = (event_t *)(tail + sizeof(EVENT_MARKER));
+      const uint32_t flags = event_flags(*marker);
+      if (eq->_filter != NULL &&
+          !event_filter_match(eq->_filter, evt->event_id)) {
+        eq->stats.filtered++;
+      } else if (drop_expired && (flags & EVENT_FLAG_EXPIRY)) {
+        // Read the clock once, the first time an expiry is checked
+        if (now == 0) {
+          now = event_clock_now(eq->config.clock);
+        }
+        if (event_expiry(evt, flags) > now) {
+          break;
+        }
+        eq->stats.expired++;
+      } else {
+        break;
+      }
+
+      event_release_shared(evt, flags);
+      const uint32_t size = event_queue_record_size(eq, evt, flags);
+      tail += size;
+      skip_bytes += size;
+      available_bytes -= size;
+      evt = NULL;
+    }
+    if (tail == end) {
+      tail = start;
+    }
+  }
+
+  if (skip_bytes > 0) {
+    circular_buffer_consume(&eq->_cb, skip_bytes);
+    event_queue_notify_space(eq);
+  }
+  return evt;
+}
+
+/**
+ * Call the notify function if the consumer armed it
+ *
+ *  The event was produced before the check, so a consumer arming after it
+ *  finds the event when it rechecks.
+ *
+ * @param eq Event Queue
+ */
+static inline void event_queue_notify_consumer(event_queue_t *const eq) {
+  if (eq->config.notify && atomic_load(&eq->_notify_armed) &&
+      atomic_exchange(&eq->_notify_armed, 0)) {
+    eq->config.notify(eq->config.notify_context);
+  }
+}
+
+bool event_queue_init(event_queue_t *const eq,
+                      event_queue_config_t *const config) {
+  if (config->buffer == NULL)
+    return false;
+  if (config->buffer_len == 0)
+    return false;
+  memcpy(&eq->config, config, sizeof(event_queue_config_t));
+  if (!config->skip_clear) {
+    memset(config->buffer, 0, config->buffer_len);
+  }
+  circular_buffer_init(&eq->_cb, config->buffer, config->buffer_len,
+                       config->use_atomics);
+  atomic_store(&eq->_space_needed, 0);
+  atomic_store(&eq->_space_seq, 0);
+  eq->_filter = NULL;
+  atomic_store(&eq->_notify_armed, 0);
+  eq->_iov_events = 0;
+  memset(&eq->stats, 0, sizeof(event_queue_stats_t));
+  if (config->latency_histogram) {
+    latency_histogram_reset(config->latency_histogram);
+  }
+  return true;
+}
+
+void event_queue_clear(event_queue_t *const eq) {
+  // Drop the payload references held by shared events
+  uint32_t available_bytes;
+  uint8_t *tail = (uint8_t *)circular_buffer_tail(&eq->_cb, &available_bytes);
+  uint8_t *const start = (uint8_t *)eq->_cb.buffer;
+  uint8_t *const end = start + eq->_cb.length;
+  while (available_bytes > 0) {
+    if (*tail == PADDING) {
+      tail++;
+      available_bytes--;
+    } else {
+      const uint32_t flags = event_flags(*(uint32_t *)tail);
+      event_t *const evt = (event_t *)(tail + sizeof(EVENT_MARKER));
+      event_release_shared(evt, flags);
+      const uint32_t size = event_queue_record_size(eq, evt, flags);
+      tail += size;
+      available_bytes -= size;
+    }
+    if (tail == end) {
+      tail = start;
+    }
+  }
+  circular_buffer_clear(&eq->_cb);
+  eq->_iov_events = 0;
+  event_queue_notify_space(eq);
+}
+
+/**
+ * Put an event with optional fields on the event queue
+ *
+ * @param eq Event Queue
+ * @param flags Optional fields beyond those from the configuration
+ * @param expiry Expiry time, used with EVENT_FLAG_EXPIRY
+ * @param event_id Event identifier
+ * @param event_data Data to accompany event
+ * @param event_data_len Size of event data
+ * @return true if the event was placed
+ */
+static bool event_queue_put_ext(event_queue_t *const eq, uint32_t flags,
+                                const uint64_t expiry,
+                                const event_id_t event_id,
+                                void *const event_data,
+                                const uint32_t event_data_len) {
+  // If locking function present, lock
+  if (eq->config.lock) {
+    eq->config.lock();
+  }
+
+  flags |= event_queue_put_flags(eq);
+  if (!(flags & EVENT_FLAG_SHARED) &&
+      event_queue_compresses(eq, event_data_len)) {
+    flags |= EVENT_FLAG_COMPRESSED;
+  }
+  uint64_t ext[3];
+  uint32_t ext_count = 0;
+  if (flags & EVENT_FLAG_TIMESTAMP) {
+    ext[ext_count++] = event_clock_now(eq->config.clock);
+  }
+  if (flags & EVENT_FLAG_EXPIRY) {
+    ext[ext_count++] = expiry;
+  }
+
+  bool placed;
+  if (flags & EVENT_FLAG_COMPRESSED) {
+    ext[ext_count++] = event_data_len;
+    placed = event_queue_write_compressed(eq, flags, ext, event_id, event_data,
+                                          event_data_len);
+  } else {
+    placed = event_queue_write(eq, flags, ext, event_id, event_data,
+                               event_data_len);
+  }
+
+  if (placed && eq->config.capture) {
+    event_capture_write(eq->config.capture, event_id, event_data,
+                        event_data_len);
+  }
 
   // If unlock function present, unlock
   if (eq->config.unlock) {
     eq->config.unlock();
   }
 
-  return true;
+  if (placed) {
+    event_queue_notify_consumer(eq);
+  }
+  return placed;
 }
 
-event_t *event_queue_get(event_queue_t *const eq) {
-  uint32_t available_bytes;
-  void *tail = circular_buffer_tail(&eq->_cb, &available_bytes);
+bool event_queue_put(event_queue_t *const eq, const event_id_t event_id,
+                     void *const event_data, const uint32_t event_data_len) {
+  return event_queue_put_ext(eq, 0, 0, event_id, event_data, event_data_len);
+}
 
-  // Consume padding if present
-  while (available_bytes > 0 && *(uint8_t *)tail == PADDING) {
-    circular_buffer_consume(&eq->_cb, sizeof(PADDING));
-    tail = circular_buffer_tail(&eq->_cb, &available_bytes);
+bool event_queue_put_expiry(event_queue_t *const eq,
+                            const event_id_t event_id, void *const event_data,
+                            const uint32_t event_data_len,
+                            const uint64_t expiry) {
+  return event_queue_put_ext(eq, EVENT_FLAG_EXPIRY, expiry, event_id,
+                             event_data, event_data_len);
+}
+
+bool event_queue_put_shared(event_queue_t *const eq,
+                            const event_id_t event_id, void *const payload,
+                            const uint32_t payload_len) {
+  if (payload_len > payload_header(payload)->pool->payload_size) {
+    return false;
   }
+  return event_queue_put_ext(eq, EVENT_FLAG_SHARED, 0, event_id, payload,
+                             payload_len);
+}
 
-  // No data
-  if (available_bytes == 0) {
-    return NULL;
+uint32_t event_queue_put_batch(event_queue_t *const eq,
+                               const event_t *const events,
+                               const uint32_t count) {
+  // If locking function present, lock
+  if (eq->config.lock) {
+    eq->config.lock();
+  }
+
+  const uint32_t flags = event_queue_put_flags(eq);
+  uint64_t put_time = 0;
+  if (flags & EVENT_FLAG_TIMESTAMP) {
+    put_time = event_clock_now(eq->config.clock);
+  }
+
+  // Largest leading run of events that fits one reservation
+  uint32_t avail_space;
+  circular_buffer_head(&eq->_cb, &avail_space);
+  const uint32_t contig_space = circular_buffer_contiguous_free_space(&eq->_cb);
+  uint32_t limit = avail_space;
+  if (contig_space < avail_space) {
+    // Free space is split, the run goes before the end or after a wrap
+    limit = (contig_space > avail_space - contig_space)
+                ? contig_space
+                : avail_space - contig_space;
+  }
+  uint32_t placed = 0;
+  uint32_t total_size = 0;
+  while (placed < count) {
+    const uint32_t size =
+        event_queue_item_size(eq, flags, events[placed].event_data_length);
+    if (size > limit - total_size) {
+      break;
+    }
+    total_size += size;
+    placed++;
+  }
+
+  if (placed > 0) {
+    // Cannot fail, the run fits the contiguous space before or after a wrap
+    uint8_t *head_ptr = event_queue_reserve(eq, total_size);
+    for (uint32_t i = 0; i < placed; i++) {
+      const event_t *const evt = &events[i];
+      const uint32_t size =
+          event_queue_item_size(eq, flags, evt->event_data_length);
+      event_queue_encode(eq, head_ptr, size, flags, &put_time, evt->event_id,
+                         evt->event_data, evt->event_data_length);
+      head_ptr += size;
+      if (eq->config.capture) {
+        event_capture_write(eq->config.capture, evt->event_id,
+                            evt->event_data, evt->event_data_length);
+      }
+    }
+    // Publish the whole run at once
+    circular_buffer_produce(&eq->_cb, total_size);
+    for (uint32_t i = 0; i < placed; i++) {
+      EEQ_TRACE_PUT(eq, events[i].event_id, events[i].event_data_length,
+                    eq->_cb.fill_count);
+    }
+  }
+
+  // If unlock function present, unlock
+  if (eq->config.unlock) {
+    eq->config.unlock();
+  }
+
+  if (placed > 0) {
+    event_queue_notify_consumer(eq);
+  }
+  return placed;
+}
+
+uint32_t event_queue_put_size(const event_queue_t *const eq,
+                              const uint32_t event_data_len) {
+  return event_queue_item_size(eq, event_queue_put_flags(eq), event_data_len);
+}
+
+uint32_t event_queue_drop_expired(event_queue_t *const eq) {
+  const uint64_t expired = eq->stats.expired;
+  uint32_t marker;
+  event_queue_peek(eq, &marker, true);
+  return (uint32_t)(eq->stats.expired - expired);
+}
+
+/**
+ * Withdraw the space request of a producer that stopped waiting
+ *
+ *  The request may be shared with other parked producers needing as much, so
+ *  they are woken to publish theirs again.
+ *
+ * @param eq Event Queue
+ * @param space_needed Space the producer published
+ */
+static void event_queue_withdraw_space(event_queue_t *const eq,
+                                       const uint32_t space_needed) {
+  int needed = (int)space_needed;
+  if (atomic_compare_exchange_strong(&eq->_space_needed, &needed, 0)) {
+    atomicFetchAdd(&eq->_space_seq, 1);
+    event_wait_wake(&eq->_space_seq);
   }
+}
 
-  // If there are bytes, it should be at least the size of an base event
-  assert(available_bytes >= sizeof(event_t) + sizeof(EVENT_MARKER));
+bool event_queue_put_timeout(event_queue_t *const eq,
+                             const event_id_t event_id, void *const event_data,
+                             const uint32_t event_data_len,
+                             const uint64_t timeout_ns) {
+  const uint64_t now = event_clock_monotonic_ns();
+  const uint64_t deadline = (timeout_ns < EVENT_WAIT_FOREVER - now)
+                                ? now + timeout_ns
+                                : EVENT_WAIT_FOREVER;
 
-// Provide pointer past the event marker
-#ifdef _MSC_VER
-  ((uint32_t *)tail) += sizeof(EVENT_MARKER);
-#else
-  tail += sizeof(EVENT_MARKER);
-#endif
+  // An event larger than the buffer can never be placed
+  const uint32_t space_needed =
+      event_queue_compresses(eq, event_data_len)
+          ? event_queue_item_size(
+                eq, event_queue_put_flags(eq) | EVENT_FLAG_COMPRESSED,
+                event_compress_bound(event_data_len))
+          : event_queue_item_size(eq, event_queue_put_flags(eq),
+                                  event_data_len);
+  if (space_needed > eq->_cb.length) {
+    return false;
+  }
 
-  return (event_t *)tail;
+  bool published = false;
+  for (uint32_t attempt = 0;; attempt++) {
+    int seq = 0;
+    if (event_wait_parks(&eq->config.put_wait, attempt)) {
+      // Publish the space needed before the final check, so the consumer
+      // either sees it or frees the space before the check
+      int needed = atomic_load(&eq->_space_needed);
+      while ((needed == 0 || needed > (int)space_needed) &&
+             !atomic_compare_exchange_weak(&eq->_space_needed, &needed,
+                                           (int)space_needed)) {
+      }
+      seq = atomic_load(&eq->_space_seq);
+      published = true;
+    }
+    if (event_queue_put(eq, event_id, event_data, event_data_len)) {
+      if (published) {
+        event_queue_withdraw_space(eq, space_needed);
+      }
+      return true;
+    }
+    if (!event_wait_step(&eq->config.put_wait, attempt, &eq->_space_seq, seq,
+                         deadline)) {
+      if (published) {
+        event_queue_withdraw_space(eq, space_needed);
+      }
+      return false;
+    }
+  }
+}
+
+event_t *event_queue_get(event_queue_t *const eq) {
+  uint32_t marker;
+  event_t *const evt =
+      event_queue_peek(eq, &marker, eq->config.drop_expired);
+  if (evt != NULL) {
+    // Streamed data is not in any cache, start fetching it
+    if (eq->config.copy_stream_threshold &&
+        evt->event_data_length >= eq->config.copy_stream_threshold) {
+      event_copy_prefetch(evt->event_data, evt->event_data_length);
+    }
+    EEQ_TRACE_GET(eq, evt->event_id, evt->event_data_length,
+                  eq->_cb.fill_count);
+  }
+  return evt;
+}
+
+/**
+ * Remove the event at the tail of the buffer
+ *
+ * @param eq Event Queue
+ * @param evt Event returned by event_queue_peek
+ * @param marker Marker of the event
+ */
+static void event_queue_remove(event_queue_t *const eq, event_t *const evt,
+                               const uint32_t marker) {
+  const uint32_t flags = event_flags(marker);
+  if ((flags & EVENT_FLAG_TIMESTAMP) && eq->config.latency_histogram) {
+    uint64_t put_time;
+    memcpy(&put_time, evt + 1, sizeof(put_time));
+    const uint64_t now = event_clock_now(eq->config.clock);
+    latency_histogram_record(eq->config.latency_histogram,
+                             (now > put_time) ? now - put_time : 0U);
+  }
+
+  // The event may be overwritten once consumed
+  const event_id_t event_id = evt->event_id;
+  const uint32_t event_data_len = evt->event_data_length;
+  event_release_shared(evt, flags);
+  circular_buffer_consume(&eq->_cb, sizeof(EVENT_MARKER) + sizeof(event_t) +
+                                        event_ext_size(flags) +
+                                        event_ring_data_length(evt, flags));
+  event_queue_notify_space(eq);
+  EEQ_TRACE_POP(eq, event_id, event_data_len, eq->_cb.fill_count);
+  (void)event_id;
+  (void)event_data_len;
 }
 
 void event_queue_pop(event_queue_t *const eq) {
-  event_t *const evt = event_queue_get(eq);
+  uint32_t marker;
+  event_t *const evt =
+      event_queue_peek(eq, &marker, eq->config.drop_expired);
   if (evt != NULL) {
-    circular_buffer_consume(&eq->_cb, sizeof(event_t) + evt->event_data_length +
-                                          sizeof(EVENT_MARKER));
+    event_queue_remove(eq, evt, marker);
+  }
+}
+
+bool event_queue_arm_notify(event_queue_t *const eq) {
+  atomic_store(&eq->_notify_armed, 1);
+  uint32_t marker;
+  if (event_queue_peek(eq, &marker, eq->config.drop_expired) == NULL) {
+    return true;
+  }
+  // An event arrived, disarm unless a producer already took the notify
+  return atomic_exchange(&eq->_notify_armed, 0) == 0;
+}
+
+void event_queue_set_filter(event_queue_t *const eq,
+                            const event_filter_t *const filter) {
+  eq->_filter = filter;
+}
+
+uint32_t event_queue_get_iov(event_queue_t *const eq, struct iovec *const iov,
+                             const uint32_t iovcnt,
+                             const bool include_headers) {
+  // Consume leading padding, filtered and expired events as get does
+  uint32_t marker;
+  eq->_iov_events = 0;
+  if (event_queue_peek(eq, &marker, eq->config.drop_expired) == NULL) {
+    return 0;
+  }
+
+  uint32_t available_bytes;
+  uint8_t *tail = (uint8_t *)circular_buffer_tail(&eq->_cb, &available_bytes);
+  uint8_t *const start = (uint8_t *)eq->_cb.buffer;
+  uint8_t *const end = start + eq->_cb.length;
+  uint64_t now = 0;
+  uint32_t count = 0;
+
+  // Walk the records from the tail without consuming them. Records never
+  // straddle the end of the buffer, so each one maps to contiguous memory.
+  while (available_bytes > 0) {
+    if (*tail == PADDING) {
+      tail++;
+      available_bytes--;
+    } else {
+      event_t *const evt = (event_t *)(tail + sizeof(EVENT_MARKER));
+      const uint32_t flags = event_flags(*(uint32_t *)tail);
+      const uint32_t size = event_queue_record_size(eq, evt, flags);
+      if (eq->_filter != NULL &&
+          !event_filter_match(eq->_filter, evt->event_id)) {
+        // Not mapped, release_iov skips it without counting its bytes
+      } else {
+        if (eq->config.drop_expired && (flags & EVENT_FLAG_EXPIRY)) {
+          if (now == 0) {
+            now = event_clock_now(eq->config.clock);
+          }
+          if (event_expiry(evt, flags) <= now) {
+            // Ends the mapping, the next get drops it
+            break;
+          }
+        }
+        if (include_headers && count > 0 &&
+            (uint8_t *)iov[count - 1].iov_base + iov[count - 1].iov_len ==
+                tail) {
+          iov[count - 1].iov_len += size;
+        } else if (count == iovcnt) {
+          break;
+        } else if (include_headers) {
+          iov[count].iov_base = tail;
+          iov[count].iov_len = size;
+          count++;
+        } else {
+          iov[count].iov_base = evt->event_data;
+          iov[count].iov_len = evt->event_data_length;
+          count++;
+        }
+        eq->_iov_events++;
+      }
+      tail += size;
+      available_bytes -= size;
+    }
+    if (tail == end) {
+      tail = start;
+    }
+  }
+  return count;
+}
+
+uint32_t event_queue_release_iov(event_queue_t *const eq, const uint32_t bytes,
+                                 const bool include_headers) {
+  uint32_t released = 0;
+  uint32_t marker;
+  event_t *evt;
+  // Mapped events are released even if they expired since being mapped, a
+  // zero length event after the mapped ones is left for the next get_iov
+  while (eq->_iov_events > 0 &&
+         (evt = event_queue_peek(eq, &marker, false)) != NULL) {
+    const uint32_t size =
+        include_headers ? event_queue_record_size(eq, evt, event_flags(marker))
+                        : evt->event_data_length;
+    if (size > bytes - released) {
+      break;
+    }
+    released += size;
+    eq->_iov_events--;
+    event_queue_remove(eq, evt, marker);
   }
+  return released;
+}
+
+// Flags of an event in the buffer, stored in the marker before it
+static inline uint32_t event_queue_event_flags(const event_t *const evt) {
+  uint32_t marker;
+  memcpy(&marker, (const uint8_t *)evt - sizeof(EVENT_MARKER), sizeof(marker));
+  return event_flags(marker);
+}
+
+uint32_t event_queue_data_length(const event_t *const evt) {
+  const uint32_t flags = event_queue_event_flags(evt);
+  if (!(flags & EVENT_FLAG_COMPRESSED)) {
+    return evt->event_data_length;
+  }
+  // Original size is the last optional field
+  uint64_t original_len;
+  memcpy(&original_len,
+         (const uint8_t *)(evt + 1) + event_ext_size(flags) - sizeof(uint64_t),
+         sizeof(original_len));
+  return (uint32_t)original_len;
+}
+
+bool event_queue_read_data(const event_t *const evt, void *const dst,
+                           const uint32_t dst_len) {
+  const uint32_t len = event_queue_data_length(evt);
+  if (len > dst_len) {
+    return false;
+  }
+  if (len == evt->event_data_length) {
+    memcpy(dst, evt->event_data, len);
+    return true;
+  }
+  return event_decompress(evt->event_data, evt->event_data_length, dst,
+                          dst_len) == len;
+}
+
+bool event_queue_latency_snapshot(event_queue_t *const eq,
+                                  latency_histogram_t *const out,
+                                  const bool reset) {
+  if (eq->config.latency_histogram == NULL) {
+    return false;
+  }
+  memcpy(out, eq->config.latency_histogram, sizeof(latency_histogram_t));
+  if (reset) {
+    latency_histogram_reset(eq->config.latency_histogram);
+  }
+  return true;
 }
@@ -27,7 +27,24 @@
 #include <stdint.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#include <stddef.h>
+struct iovec {
+  void *iov_base;
+  size_t iov_len;
+};
+#else
+#include <sys/uio.h>
+#endif
+
 #include "circular_buffer.h"
+#include "event_capture.h"
+#include "event_clock.h"
+#include "event_copy.h"
+#include "event_filter.h"
+#include "event_wait.h"
+#include "latency_histogram.h"
+#include "payload_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,6 +55,13 @@ typedef uint32_t event_id_t;
 #define EVENT_MARKER (uint32_t)0xFFFFFFFF
 #define PADDING (uint8_t)0x00
 
+// Event flags are stored by clearing bits 8-15 of the event marker, keeping
+// the first byte of the marker distinct from PADDING on either endianness.
+#define EVENT_FLAG_TIMESTAMP (uint32_t)0x01  // uint64_t put time after event_t
+#define EVENT_FLAG_EXPIRY (uint32_t)0x02     // uint64_t expiry time after that
+#define EVENT_FLAG_SHARED (uint32_t)0x04     // Data is a shared payload pointer
+#define EVENT_FLAG_COMPRESSED (uint32_t)0x08 // uint64_t original size after all
+
 typedef struct {
   event_id_t event_id;
   uint32_t event_data_length;
@@ -45,6 +69,7 @@ typedef struct {
 } event_t;
 
 typedef void (*lock_unlock_func_t)();
+typedef void (*event_queue_notify_func_t)(void *const context);
 
 typedef struct {
   void *buffer;
@@ -53,11 +78,36 @@ typedef struct {
   uint32_t alignment;
   lock_unlock_func_t lock;
   lock_unlock_func_t unlock;
+  latency_histogram_t *latency_histogram; // Put to pop latency, NULL disables
+  event_clock_source_t clock;             // Clock used to stamp events
+  event_capture_t *capture;               // Records put traffic, NULL disables
+  event_wait_strategy_t put_wait;         // Wait strategy of blocking puts
+  bool skip_clear;                        // Do not zero the buffer on init
+  uint32_t copy_stream_threshold;         // Stream data from this size, 0 off
+  bool drop_expired;                      // Get skips expired events
+  event_queue_notify_func_t notify;       // Wakes an armed consumer, optional
+  void *notify_context;                   // Passed to notify
+  // Compress data from this size, 0 off. event_data and event_data_length of
+  // a compressed event describe the encoded bytes, which iovecs, coroutine
+  // batches and merge keys see as is. Read the data with
+  // event_queue_read_data. Batch and staged puts are never compressed.
+  uint32_t compress_threshold;
 } event_queue_config_t;
 
+typedef struct {
+  uint64_t filtered; // Events skipped by the consumer filter
+  uint64_t expired;  // Events dropped past their expiry time
+} event_queue_stats_t;
+
 typedef struct {
   event_queue_config_t config;
+  event_queue_stats_t stats; // Updated by the consumer
   circular_buffer_t _cb;
+  volatile atomic_int_t _space_needed; // Least free bytes a parked put needs
+  volatile atomic_int_t _space_seq;    // Bumped when parked puts are woken
+  const event_filter_t *_filter;       // Consumer event id filter
+  volatile atomic_int_t _notify_armed; // Consumer waits for a notify call
+  uint32_t _iov_events;                // Events mapped by the last get_iov
 } event_queue_t;
 
 /**
@@ -87,6 +137,109 @@ void event_queue_clear(event_queue_t *const eq);
 bool event_queue_put(event_queue_t *const eq, const event_id_t event_id,
                      void *const event_data, const uint32_t event_data_len);
 
+/**
+ * Ask for a notify call once the event queue is no longer empty
+ *
+ *  Used by consumers that suspend rather than poll. The next put calls the
+ *  configured notify function from the producer's thread, after placing its
+ *  event. Call from the consumer context: the recheck for an available event
+ *  consumes skipped records, so the notify function must not let the consumer
+ *  run elsewhere until this call has returned.
+ *
+ * @param eq Event Queue
+ * @return true if a notify call will follow, false if an event is already
+ * available
+ */
+bool event_queue_arm_notify(event_queue_t *const eq);
+
+/**
+ * Put an event with an expiry time on the event queue
+ *
+ *  Once the expiry time has passed, the event is dropped by
+ *  event_queue_drop_expired, or by event_queue_get when drop_expired is
+ *  configured, instead of being returned to the consumer.
+ *
+ * @param eq Event Queue
+ * @param event_id Event identifier
+ * @param event_data Data to accompany event
+ * @param event_data_len Size of event data
+ * @param expiry Expiry time in units of the configured clock, as returned by
+ * event_clock_now
+ * @return false if there is no space
+ */
+bool event_queue_put_expiry(event_queue_t *const eq,
+                            const event_id_t event_id, void *const event_data,
+                            const uint32_t event_data_len,
+                            const uint64_t expiry);
+
+/**
+ * Put an event referring to a shared payload on the event queue
+ *
+ *  Only a pointer to the payload is placed in the queue, so one payload can be
+ *  put on many queues without copying it. The queue takes a reference, which
+ *  event_queue_pop drops, as do events skipped by the filter or expiry and
+ *  event_queue_clear. Event records mapped by event_queue_get_iov with headers
+ *  hold the pointer rather than the payload.
+ *
+ * @param eq Event Queue
+ * @param event_id Event identifier
+ * @param payload Payload taken from a payload_pool_t
+ * @param payload_len Size of the payload data, at most the pool payload size
+ * @return false if there is no space
+ */
+bool event_queue_put_shared(event_queue_t *const eq,
+                            const event_id_t event_id, void *const payload,
+                            const uint32_t payload_len);
+
+/**
+ * Put several events on the event queue with a single reservation
+ *
+ *  Takes the lock once and publishes the events together, so the consumer
+ *  sees all of them or none. Places the longest leading run of events that
+ *  fits in contiguous free space. Batched events are stored uncompressed,
+ *  whatever the compress_threshold.
+ *
+ * @param eq Event Queue
+ * @param events Events to copy into the queue
+ * @param count Number of events
+ * @return Number of leading events placed
+ */
+uint32_t event_queue_put_batch(event_queue_t *const eq,
+                               const event_t *const events,
+                               const uint32_t count);
+
+/**
+ * Get the size of the record an uncompressed put places in the buffer
+ *
+ *  Includes the marker, event_t, the optional fields of the configuration and
+ *  alignment padding. An event whose record is larger than the buffer can
+ *  never be placed.
+ *
+ * @param eq Event Queue
+ * @param event_data_len Size of event data
+ * @return Size of the event record in bytes
+ */
+uint32_t event_queue_put_size(const event_queue_t *const eq,
+                              const uint32_t event_data_len);
+
+/**
+ * Put an event on the event queue, waiting for space
+ *
+ *  Waits following the configured put_wait strategy. Parked producers are
+ *  woken by the consumer once enough bytes have been freed for the event.
+ *
+ * @param eq Event Queue
+ * @param event_id Event identifier
+ * @param event_data Data to accompany event
+ * @param event_data_len Size of event data
+ * @param timeout_ns Time to wait for space, or EVENT_WAIT_FOREVER
+ * @return false if the event was not placed before the timeout
+ */
+bool event_queue_put_timeout(event_queue_t *const eq,
+                             const event_id_t event_id, void *const event_data,
+                             const uint32_t event_data_len,
+                             const uint64_t timeout_ns);
+
 /**
  * Get an event off the event queue
  *
@@ -102,6 +255,106 @@ event_t *event_queue_get(event_queue_t *const eq);
  */
 void event_queue_pop(event_queue_t *const eq);
 
+/**
+ * Drop expired events from the tail of the event queue
+ *
+ *  Consumes every expired event up to the first live one in a single step,
+ *  counting them in stats.expired. Call from the consumer context, for
+ *  example periodically while the consumer is busy elsewhere.
+ *
+ * @param eq Event Queue
+ * @return Number of events dropped
+ */
+uint32_t event_queue_drop_expired(event_queue_t *const eq);
+
+/**
+ * Attach an event id filter to the consumer
+ *
+ *  event_queue_get and event_queue_pop skip and consume events whose id does
+ *  not match the filter, counting them in stats.filtered. The filter must
+ *  outlive its use by the queue and may be changed from the consumer context.
+ *
+ * @param eq Event Queue
+ * @param filter Event filter, NULL to receive all events
+ */
+void event_queue_set_filter(event_queue_t *const eq,
+                            const event_filter_t *const filter);
+
+/**
+ * Map readable events to an iovec array without removing them
+ *
+ *  The iovecs point straight into the event queue memory and stay valid until
+ *  the events are released. Without headers each iovec holds the data of one
+ *  event. With headers each iovec holds whole contiguous event records,
+ *  including markers, event_t headers and alignment padding. Events not
+ *  matching the consumer filter are left out, and with drop_expired the
+ *  mapping ends before the first expired event, as event_queue_get would
+ *  skip them. Without headers, events compressed by a queue with a
+ *  compress_threshold map to their encoded bytes, which
+ *  event_queue_release_iov also counts.
+ *
+ * @param eq Event Queue
+ * @param iov Array of iovecs to fill
+ * @param iovcnt Number of iovecs in the array
+ * @param include_headers Map whole event records rather than event data
+ * @return Number of iovecs filled
+ */
+uint32_t event_queue_get_iov(event_queue_t *const eq, struct iovec *const iov,
+                             const uint32_t iovcnt, const bool include_headers);
+
+/**
+ * Remove the events covered by the first bytes of an event_queue_get_iov
+ *
+ *  Only events that are completely covered are removed, and never more than
+ *  the last event_queue_get_iov mapped. A partially transferred event remains
+ *  in the queue, the caller must skip the difference between bytes and the
+ *  return value when resubmitting it.
+ *
+ * @param eq Event Queue
+ * @param bytes Number of bytes transferred from the iovecs
+ * @param include_headers Must match the event_queue_get_iov call
+ * @return Number of bytes released
+ */
+uint32_t event_queue_release_iov(event_queue_t *const eq, const uint32_t bytes,
+                                 const bool include_headers);
+
+/**
+ * Get the original size of an event's data
+ *
+ *  Differs from event_data_length for events compressed by a queue with a
+ *  compress_threshold, whose event_data points at the compressed bytes.
+ *
+ * @param evt Event returned by event_queue_get
+ * @return Size of the data before compression
+ */
+uint32_t event_queue_data_length(const event_t *const evt);
+
+/**
+ * Copy an event's data into a buffer, decompressing it if needed
+ *
+ * @param evt Event returned by event_queue_get
+ * @param dst Buffer of at least event_queue_data_length bytes
+ * @param dst_len Size of the buffer
+ * @return false if the buffer is too small or the data is corrupt
+ */
+bool event_queue_read_data(const event_t *const evt, void *const dst,
+                           const uint32_t dst_len);
+
+/**
+ * Snapshot the put to pop latency histogram
+ *
+ *  Latency is recorded in the units of the configured clock when an event is
+ *  popped. Call from the consumer context.
+ *
+ * @param eq Event Queue
+ * @param out Histogram to copy into
+ * @param reset Reset the queue histogram after copying
+ * @return false if latency tracking is not configured
+ */
+bool event_queue_latency_snapshot(event_queue_t *const eq,
+                                  latency_histogram_t *const out,
+                                  const bool reset);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
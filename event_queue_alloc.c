@@ -0,0 +1,162 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "event_queue_alloc.h"
+#include <stdlib.h>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define EVENT_QUEUE_MAX_NUMA_NODES 256
+#define EVENT_QUEUE_MAX_PREFAULT_THREADS 64
+
+typedef struct {
+  volatile uint8_t *start;
+  size_t length;
+  size_t page_size;
+} prefault_args_t;
+
+static void *prefault(void *arg) {
+  const prefault_args_t *const args = (const prefault_args_t *)arg;
+  for (size_t offset = 0; offset < args->length; offset += args->page_size) {
+    args->start[offset] = 0;
+  }
+  return NULL;
+}
+
+static void prefault_parallel(uint8_t *const buffer, const size_t length,
+                              const size_t page_size, uint32_t threads) {
+  const size_t pages = length / page_size;
+  if (threads > EVENT_QUEUE_MAX_PREFAULT_THREADS) {
+    threads = EVENT_QUEUE_MAX_PREFAULT_THREADS;
+  }
+  if (threads > pages) {
+    threads = (uint32_t)pages;
+  }
+  pthread_t thread_ids[EVENT_QUEUE_MAX_PREFAULT_THREADS];
+  prefault_args_t args[EVENT_QUEUE_MAX_PREFAULT_THREADS];
+  uint32_t started = 0;
+  for (uint32_t i = 0; i < threads; i++) {
+    const size_t first = pages * i / threads;
+    const size_t last = pages * (i + 1) / threads;
+    args[i].start = buffer + first * page_size;
+    args[i].length = (last - first) * page_size;
+    args[i].page_size = page_size;
+    // The calling thread takes the last slice, and any a thread failed to
+    if (i + 1 == threads ||
+        pthread_create(&thread_ids[started], NULL, prefault, &args[i]) != 0) {
+      prefault(&args[i]);
+    } else {
+      started++;
+    }
+  }
+  for (uint32_t i = 0; i < started; i++) {
+    pthread_join(thread_ids[i], NULL);
+  }
+}
+
+static bool bind_node(void *const buffer, const size_t length,
+                      const int node) {
+  unsigned long nodemask[EVENT_QUEUE_MAX_NUMA_NODES / (8 * sizeof(long))] = {
+      0};
+  const unsigned long bits = 8 * sizeof(unsigned long);
+  if (node < 0 || node >= EVENT_QUEUE_MAX_NUMA_NODES)
+    return false;
+  nodemask[node / bits] |= 1UL << (node % bits);
+  return syscall(SYS_mbind, buffer, length, MPOL_BIND, nodemask,
+                 EVENT_QUEUE_MAX_NUMA_NODES + 1, 0) == 0;
+}
+
+bool event_queue_alloc(event_queue_memory_t *const mem,
+                       const event_queue_alloc_config_t *const config) {
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  void *buffer = MAP_FAILED;
+  mem->huge_pages = false;
+
+  if (config->length == 0)
+    return false;
+
+  if (config->huge_pages) {
+    mem->mapped_length = (config->length + EVENT_QUEUE_HUGE_PAGE_SIZE - 1) &
+                         ~(EVENT_QUEUE_HUGE_PAGE_SIZE - 1);
+    buffer = mmap(NULL, mem->mapped_length, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    mem->huge_pages = (buffer != MAP_FAILED);
+  }
+  if (buffer == MAP_FAILED) {
+    mem->mapped_length = (config->length + page_size - 1) & ~(page_size - 1);
+    buffer = mmap(NULL, mem->mapped_length, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED)
+      return false;
+#if defined(MADV_HUGEPAGE)
+    if (config->huge_pages) {
+      madvise(buffer, mem->mapped_length, MADV_HUGEPAGE);
+    }
+#endif
+  }
+
+  // Bind before any page is faulted in, so every page lands on the node
+  if (config->numa_node != EVENT_QUEUE_NUMA_ANY &&
+      !bind_node(buffer, mem->mapped_length, config->numa_node)) {
+    munmap(buffer, mem->mapped_length);
+    return false;
+  }
+
+  if (config->prefault_threads > 0) {
+    prefault_parallel((uint8_t *)buffer, mem->mapped_length,
+                      mem->huge_pages ? EVENT_QUEUE_HUGE_PAGE_SIZE : page_size,
+                      config->prefault_threads);
+  }
+
+  mem->buffer = buffer;
+  return true;
+}
+
+void event_queue_free(event_queue_memory_t *const mem) {
+  if (mem->buffer != NULL) {
+    munmap(mem->buffer, mem->mapped_length);
+    mem->buffer = NULL;
+  }
+}
+
+#else
+
+bool event_queue_alloc(event_queue_memory_t *const mem,
+                       const event_queue_alloc_config_t *const config) {
+  if (config->length == 0)
+    return false;
+  mem->buffer = calloc(1, config->length);
+  mem->mapped_length = config->length;
+  mem->huge_pages = false;
+  return mem->buffer != NULL;
+}
+
+void event_queue_free(event_queue_memory_t *const mem) {
+  free(mem->buffer);
+  mem->buffer = NULL;
+}
+
+#endif // __linux__
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENT_QUEUE_ALLOC_H
+#define EVENT_QUEUE_ALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define EVENT_QUEUE_NUMA_ANY (-1)
+#define EVENT_QUEUE_HUGE_PAGE_SIZE (size_t)(2 * 1024 * 1024)
+
+typedef struct {
+  uint32_t length;           // Size of the event queue buffer
+  int numa_node;             // Node to bind to, or EVENT_QUEUE_NUMA_ANY
+  bool huge_pages;           // Back with huge pages where available
+  uint32_t prefault_threads; // Threads faulting in pages, 0 to fault on use
+} event_queue_alloc_config_t;
+
+typedef struct {
+  void *buffer;         // Zeroed memory of at least the requested length
+  size_t mapped_length; // Size of the mapping
+  bool huge_pages;      // Backed by reserved huge pages (MAP_HUGETLB)
+} event_queue_memory_t;
+
+/**
+ * Allocate event queue memory
+ *
+ *  On Linux the memory is mapped with MAP_HUGETLB when huge pages are
+ *  requested and reserved, otherwise transparent huge pages are requested
+ *  with madvise. It is bound to the NUMA node (typically the consumer's),
+ *  then prefaulted in parallel. The memory is zeroed, so the event queue can
+ *  be initialized with skip_clear set. Elsewhere the memory comes from calloc.
+ *
+ * @param mem On output, the allocated memory
+ * @param config Allocation configuration
+ * @return false if the memory could not be allocated or bound
+ */
+bool event_queue_alloc(event_queue_memory_t *const mem,
+                       const event_queue_alloc_config_t *const config);
+
+/**
+ * Release memory from event_queue_alloc
+ *
+ * @param mem Allocated memory
+ */
+void event_queue_free(event_queue_memory_t *const mem);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // EVENT_QUEUE_ALLOC_H
@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENT_QUEUE_CORO_HPP
+#define EVENT_QUEUE_CORO_HPP
+
+#include <atomic>
+#include <coroutine>
+
+#include "event_queue.h"
+
+namespace eeq {
+
+// Resumes a coroutine woken by a producer, e.g. by posting it to a scheduler
+typedef void (*executor_func_t)(std::coroutine_handle<> handle,
+                                void *const context);
+
+/**
+ * Awaitable consumer front end of an event queue
+ *
+ *  A coroutine awaiting an empty queue is suspended without a thread. The
+ *  put that ends the wait hands it to the executor, or resumes it inline on
+ *  the producer's thread when there is no executor. There may be one waiting
+ *  coroutine at a time, the queue's single consumer.
+ */
+class event_queue_coro {
+public:
+  /**
+   * Attach to an initialized event queue, before producers start
+   *
+   * @param eq Event Queue, its notify function is taken over
+   * @param executor Resumes woken coroutines, NULL resumes inline
+   * @param context Passed to the executor
+   */
+  event_queue_coro(event_queue_t &eq, executor_func_t executor = nullptr,
+                   void *const context = nullptr)
+      : eq_(eq), executor_(executor), context_(context), state_(IDLE) {
+    eq_.config.notify = &event_queue_coro::notify;
+    eq_.config.notify_context = this;
+  }
+
+  ~event_queue_coro() {
+    eq_.config.notify = nullptr;
+    eq_.config.notify_context = nullptr;
+  }
+
+  event_queue_coro(const event_queue_coro &) = delete;
+  event_queue_coro &operator=(const event_queue_coro &) = delete;
+
+  // Awaits the next event, which stays queued until event_queue_pop
+  class next_awaiter {
+  public:
+    explicit next_awaiter(event_queue_coro &q) : q_(q), evt_(nullptr) {}
+
+    bool await_ready() {
+      evt_ = event_queue_get(&q_.eq_);
+      return evt_ != nullptr;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+      return q_.suspend(handle);
+    }
+
+    event_t *await_resume() {
+      return evt_ != nullptr ? evt_ : event_queue_get(&q_.eq_);
+    }
+
+  private:
+    event_queue_coro &q_;
+    event_t *evt_;
+  };
+
+  // Awaits at least one event, then maps up to iovcnt event payloads
+  class batch_awaiter {
+  public:
+    batch_awaiter(event_queue_coro &q, struct iovec *const iov,
+                  const uint32_t iovcnt)
+        : q_(q), iov_(iov), iovcnt_(iovcnt), count_(0) {}
+
+    bool await_ready() {
+      count_ = event_queue_get_iov(&q_.eq_, iov_, iovcnt_, false);
+      return count_ > 0;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+      return q_.suspend(handle);
+    }
+
+    uint32_t await_resume() {
+      return count_ > 0 ? count_
+                        : event_queue_get_iov(&q_.eq_, iov_, iovcnt_, false);
+    }
+
+  private:
+    event_queue_coro &q_;
+    struct iovec *const iov_;
+    const uint32_t iovcnt_;
+    uint32_t count_;
+  };
+
+  /**
+   * Await the next event
+   *
+   * @return Awaitable yielding the event at the tail, pop it once handled
+   */
+  next_awaiter next() { return next_awaiter(*this); }
+
+  /**
+   * Await a batch of events
+   *
+   * @param iov Array of iovecs to fill with event data
+   * @param iovcnt Number of iovecs in the array
+   * @return Awaitable yielding the number of iovecs filled, remove the events
+   * with event_queue_release_iov without headers. Events compressed by the
+   * queue yield their encoded bytes.
+   */
+  batch_awaiter next_batch(struct iovec *const iov, const uint32_t iovcnt) {
+    return batch_awaiter(*this, iov, iovcnt);
+  }
+
+private:
+  // Handshake between a suspending coroutine and the notify that wakes it
+  enum { IDLE, SUSPENDING, SUSPENDED, NOTIFIED };
+
+  /**
+   * Arm the notify and decide whether to suspend
+   *
+   *  The recheck in event_queue_arm_notify consumes skipped records, so a
+   *  notify arriving before it completes only marks the wait as ended. The
+   *  coroutine then carries on here instead of being resumed by the producer
+   *  while it still runs on this thread. With several producers a notify can
+   *  be stale, its event taken by a wait the notify of another producer ended,
+   *  so the queue is checked again before the wait ends.
+   *
+   * @param handle Coroutine to suspend
+   * @return true if suspended, a later notify resumes the coroutine
+   */
+  bool suspend(std::coroutine_handle<> handle) {
+    waiter_ = handle;
+    for (;;) {
+      state_.store(SUSPENDING);
+      if (!event_queue_arm_notify(&eq_)) {
+        state_.store(IDLE);
+        return false;
+      }
+      int expected = SUSPENDING;
+      if (state_.compare_exchange_strong(expected, SUSPENDED)) {
+        return true;
+      }
+      // Notified while suspending
+      state_.store(IDLE);
+      if (event_queue_get(&eq_) != nullptr) {
+        return false;
+      }
+    }
+  }
+
+  static void notify(void *const context) {
+    event_queue_coro *const q = static_cast<event_queue_coro *>(context);
+    if (q->state_.exchange(NOTIFIED) != SUSPENDED) {
+      return;
+    }
+    // This thread owns the suspended consumer until it resumes it, a stale
+    // notify suspends it again
+    q->state_.store(IDLE);
+    if (event_queue_get(&q->eq_) == nullptr && q->suspend(q->waiter_)) {
+      return;
+    }
+    const std::coroutine_handle<> waiter = q->waiter_;
+    if (q->executor_ != nullptr) {
+      q->executor_(waiter, q->context_);
+    } else {
+      waiter.resume();
+    }
+  }
+
+  event_queue_t &eq_;
+  executor_func_t executor_;
+  void *context_;
+  std::coroutine_handle<> waiter_;
+  std::atomic<int> state_;
+};
+
+} // namespace eeq
+
+#endif // EVENT_QUEUE_CORO_HPP
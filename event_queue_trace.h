@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENT_QUEUE_TRACE_H
+#define EVENT_QUEUE_TRACE_H
+
+// User-space static tracepoints, enabled by building with EEQ_USDT defined.
+// Each probe is a single nop until a tracer attaches, e.g.
+//
+//   bpftrace -e 'usdt:./main:eeq:put { @[arg1] = count(); }'
+//
+// Probe arguments are (queue, event id, event data length, fill count) unless
+// noted otherwise.
+
+#if defined(EEQ_USDT)
+#include <sys/sdt.h>
+
+#define EEQ_TRACE_PUT(eq, id, len, fill)                                       \
+  DTRACE_PROBE4(eeq, put, eq, id, len, fill)
+#define EEQ_TRACE_REJECT_FULL(eq, id, len, fill)                               \
+  DTRACE_PROBE4(eeq, reject_full, eq, id, len, fill)
+#define EEQ_TRACE_REJECT_FRAGMENTED(eq, id, len, fill)                         \
+  DTRACE_PROBE4(eeq, reject_fragmented, eq, id, len, fill)
+// (queue, padding bytes, fill count)
+#define EEQ_TRACE_WRAP(eq, padding, fill)                                      \
+  DTRACE_PROBE3(eeq, wrap, eq, padding, fill)
+#define EEQ_TRACE_GET(eq, id, len, fill)                                       \
+  DTRACE_PROBE4(eeq, get, eq, id, len, fill)
+#define EEQ_TRACE_POP(eq, id, len, fill)                                       \
+  DTRACE_PROBE4(eeq, pop, eq, id, len, fill)
+#else
+#define EEQ_TRACE_PUT(eq, id, len, fill) ((void)0)
+#define EEQ_TRACE_REJECT_FULL(eq, id, len, fill) ((void)0)
+#define EEQ_TRACE_REJECT_FRAGMENTED(eq, id, len, fill) ((void)0)
+#define EEQ_TRACE_WRAP(eq, padding, fill) ((void)0)
+#define EEQ_TRACE_GET(eq, id, len, fill) ((void)0)
+#define EEQ_TRACE_POP(eq, id, len, fill) ((void)0)
+#endif // EEQ_USDT
+
+#endif // EVENT_QUEUE_TRACE_H
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "event_stage.h"
+
+bool event_stage_init(event_stage_t *const stage,
+                      event_stage_config_t *const config) {
+  if (config->eq == NULL || config->events == NULL || config->data == NULL)
+    return false;
+  if (config->max_events == 0)
+    return false;
+  memcpy(&stage->config, config, sizeof(event_stage_config_t));
+  if (stage->config.flush_bytes == 0 ||
+      stage->config.flush_bytes > config->data_len) {
+    stage->config.flush_bytes = config->data_len;
+  }
+  stage->count = 0;
+  stage->length = 0;
+  stage->deadline = 0;
+  return true;
+}
+
+uint32_t event_stage_flush(event_stage_t *const stage) {
+  if (stage->count == 0) {
+    return 0;
+  }
+  event_t *const events = stage->config.events;
+  const uint32_t placed =
+      event_queue_put_batch(stage->config.eq, events, stage->count);
+  if (placed == stage->count) {
+    stage->count = 0;
+    stage->length = 0;
+    stage->deadline = 0;
+    return placed;
+  }
+
+  // The queue is full, keep the rest staged at the start of the buffers
+  if (placed > 0) {
+    const uint8_t *const rest = (const uint8_t *)events[placed].event_data;
+    const uint32_t offset = (uint32_t)(rest - stage->config.data);
+    stage->count -= placed;
+    stage->length -= offset;
+    memmove(events, &events[placed], stage->count * sizeof(event_t));
+    memmove(stage->config.data, rest, stage->length);
+    for (uint32_t i = 0; i < stage->count; i++) {
+      events[i].event_data = (uint8_t *)events[i].event_data - offset;
+    }
+  }
+  return placed;
+}
+
+bool event_stage_put(event_stage_t *const stage, const event_id_t event_id,
+                     const void *const event_data,
+                     const uint32_t event_data_len) {
+  // Staged, it would hold back every later event forever
+  if (event_queue_put_size(stage->config.eq, event_data_len) >
+      stage->config.eq->_cb.length) {
+    return false;
+  }
+  if (stage->count == stage->config.max_events ||
+      event_data_len > stage->config.data_len - stage->length) {
+    event_stage_flush(stage);
+    if (stage->count == stage->config.max_events ||
+        event_data_len > stage->config.data_len - stage->length) {
+      return false;
+    }
+  }
+
+  event_t *const evt = &stage->config.events[stage->count++];
+  evt->event_id = event_id;
+  evt->event_data_length = event_data_len;
+  evt->event_data = stage->config.data + stage->length;
+  event_copy(evt->event_data, event_data, event_data_len, 0);
+  stage->length += event_data_len;
+
+  if (stage->config.max_delay_ns && stage->count == 1) {
+    stage->deadline = event_clock_monotonic_ns() + stage->config.max_delay_ns;
+  }
+  if (stage->count == stage->config.max_events ||
+      stage->length >= stage->config.flush_bytes) {
+    event_stage_flush(stage);
+  } else if (stage->deadline) {
+    event_stage_poll(stage);
+  }
+  return true;
+}
+
+uint32_t event_stage_poll(event_stage_t *const stage) {
+  if (stage->count == 0 || stage->deadline == 0 ||
+      event_clock_monotonic_ns() < stage->deadline) {
+    return 0;
+  }
+  return event_stage_flush(stage);
+}
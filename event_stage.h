@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENT_STAGE_H
+#define EVENT_STAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "event_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef struct {
+  event_queue_t *eq;     // Queue flushed to
+  event_t *events;       // Staged event headers
+  uint32_t max_events;   // Capacity of events, flushes when full
+  uint8_t *data;         // Staged event data
+  uint32_t data_len;     // Capacity of data
+  uint32_t flush_bytes;  // Flush once this much data is staged, 0 when full
+  uint64_t max_delay_ns; // Flush once the oldest event waited this long, 0 off
+} event_stage_config_t;
+
+typedef struct {
+  event_stage_config_t config;
+  uint32_t count;    // Staged events
+  uint32_t length;   // Staged data bytes
+  uint64_t deadline; // event_clock_monotonic_ns time of the delay flush
+} event_stage_t;
+
+/**
+ * Initialize a producer staging buffer
+ *
+ *  Owned by a single producer. Events are collected and published to the
+ *  queue together with event_queue_put_batch, once a count, byte or delay
+ *  threshold is reached or on an explicit flush. Like other batch puts, the
+ *  events bypass the queue's compress_threshold.
+ *
+ * @param stage Event Stage
+ * @param config Event Stage Configuration
+ * @return false if the configuration is invalid
+ */
+bool event_stage_init(event_stage_t *const stage,
+                      event_stage_config_t *const config);
+
+/**
+ * Stage an event, flushing if a threshold is reached
+ *
+ * @param stage Event Stage
+ * @param event_id Event identifier
+ * @param event_data Data to accompany event, copied
+ * @param event_data_len Size of event data
+ * @return false if the event does not fit, even after a flush, or is too
+ * large for the queue
+ */
+bool event_stage_put(event_stage_t *const stage, const event_id_t event_id,
+                     const void *const event_data,
+                     const uint32_t event_data_len);
+
+/**
+ * Publish the staged events to the queue
+ *
+ *  Events that do not fit in the queue stay staged, in order.
+ *
+ * @param stage Event Stage
+ * @return Number of events published
+ */
+uint32_t event_stage_flush(event_stage_t *const stage);
+
+/**
+ * Flush if the oldest staged event has waited max_delay_ns
+ *
+ *  Called by idle producers, so staged events are not held indefinitely.
+ *
+ * @param stage Event Stage
+ * @return Number of events published
+ */
+uint32_t event_stage_poll(event_stage_t *const stage);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // EVENT_STAGE_H
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "event_wait.h"
+#include "event_clock.h"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+// Sleep used in place of a futex on other platforms
+#define EVENT_WAIT_SLEEP_NS 50000ULL
+
+static void event_wait_yield(void) {
+#if defined(_WIN32)
+  SwitchToThread();
+#else
+  sched_yield();
+#endif
+}
+
+static void event_wait_park(volatile atomic_int_t *const word,
+                            const int expected, const uint64_t timeout_ns) {
+#if defined(__linux__)
+  struct timespec ts;
+  ts.tv_sec = (time_t)(timeout_ns / 1000000000ULL);
+  ts.tv_nsec = (long)(timeout_ns % 1000000000ULL);
+  syscall(SYS_futex, (void *)word, FUTEX_WAIT_PRIVATE, expected,
+          (timeout_ns == EVENT_WAIT_FOREVER) ? NULL : &ts, NULL, 0);
+#else
+  const uint64_t sleep_ns =
+      (timeout_ns < EVENT_WAIT_SLEEP_NS) ? timeout_ns : EVENT_WAIT_SLEEP_NS;
+  if (atomic_load(word) != expected) {
+    return;
+  }
+#if defined(_WIN32)
+  Sleep((DWORD)((sleep_ns + 999999ULL) / 1000000ULL));
+#else
+  struct timespec ts = {0, (long)sleep_ns};
+  nanosleep(&ts, NULL);
+#endif
+#endif
+}
+
+bool event_wait_step(const event_wait_strategy_t *const strategy,
+                     const uint32_t attempt, volatile atomic_int_t *const word,
+                     const int expected, const uint64_t deadline) {
+  uint64_t now = 0;
+  if (deadline != EVENT_WAIT_FOREVER) {
+    now = event_clock_monotonic_ns();
+    if (now >= deadline) {
+      return false;
+    }
+  }
+
+  if (attempt < strategy->spin_count) {
+    event_wait_pause();
+  } else if (!event_wait_parks(strategy, attempt)) {
+    event_wait_yield();
+  } else {
+    event_wait_park(word, expected,
+                    (deadline == EVENT_WAIT_FOREVER) ? EVENT_WAIT_FOREVER
+                                                     : deadline - now);
+  }
+  return true;
+}
+
+void event_wait_wake(volatile atomic_int_t *const word) {
+#if defined(__linux__)
+  syscall(SYS_futex, (void *)word, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL,
+          0);
+#else
+  (void)word;
+#endif
+}
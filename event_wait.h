@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENT_WAIT_H
+#define EVENT_WAIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "circular_buffer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define EVENT_WAIT_FOREVER UINT64_MAX
+
+// Waiters spin, then yield, then park. Without park they keep yielding.
+typedef struct {
+  uint32_t spin_count;  // Polls separated by a pause instruction
+  uint32_t yield_count; // Polls yielding the CPU, after spinning
+  bool park;            // Sleep on a futex after yielding
+} event_wait_strategy_t;
+
+/**
+ * Hint to the CPU that the caller is spinning
+ */
+static inline void event_wait_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * Check if a wait step parks the caller
+ *
+ *  The caller must publish what it is waiting for, then read the wait word,
+ *  then check its condition once more before a parking step.
+ *
+ * @param strategy Wait strategy
+ * @param attempt Number of previous wait steps
+ * @return true if event_wait_step parks
+ */
+static inline bool event_wait_parks(const event_wait_strategy_t *const strategy,
+                                    const uint32_t attempt) {
+  return strategy->park &&
+         attempt >= strategy->spin_count + strategy->yield_count;
+}
+
+/**
+ * Wait one step of a wait strategy
+ *
+ * @param strategy Wait strategy
+ * @param attempt Number of previous wait steps
+ * @param word Word to park on
+ * @param expected Value of word read before the condition was last checked,
+ * parking returns as soon as word no longer holds it
+ * @param deadline event_clock_monotonic_ns deadline, or EVENT_WAIT_FOREVER
+ * @return false if the deadline has passed
+ */
+bool event_wait_step(const event_wait_strategy_t *const strategy,
+                     const uint32_t attempt, volatile atomic_int_t *const word,
+                     const int expected, const uint64_t deadline);
+
+/**
+ * Wake every waiter parked on a word
+ *
+ *  The word must be changed before waking.
+ *
+ * @param word Word parked on
+ */
+void event_wait_wake(volatile atomic_int_t *const word);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // EVENT_WAIT_H
@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// Log-linear bucketing: every power of two range is split into
+// LATENCY_HISTOGRAM_SUB_BUCKETS linear buckets, bounding the relative error of
+// a recorded value to 1 / LATENCY_HISTOGRAM_SUB_BUCKETS.
+#define LATENCY_HISTOGRAM_SUB_BUCKET_BITS 3
+#define LATENCY_HISTOGRAM_SUB_BUCKETS (1U << LATENCY_HISTOGRAM_SUB_BUCKET_BITS)
+#define LATENCY_HISTOGRAM_BUCKETS                                              \
+  ((64U - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1U) *                            \
+   LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+  uint64_t counts[LATENCY_HISTOGRAM_BUCKETS]; // Samples per bucket
+  uint64_t total_count;                       // Number of samples
+  uint64_t sum;                               // Sum of all samples
+  uint64_t min;                               // Smallest sample
+  uint64_t max;                               // Largest sample
+} latency_histogram_t;
+
+/**
+ * Empties the histogram
+ *
+ * @param h Histogram
+ */
+static inline void latency_histogram_reset(latency_histogram_t *const h) {
+  memset(h, 0, sizeof(latency_histogram_t));
+  h->min = UINT64_MAX;
+}
+
+/**
+ * Get the index of the most significant set bit
+ *
+ * @param value Non-zero value
+ * @return Bit index
+ */
+static inline uint32_t latency_histogram_msb(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63U - (uint32_t)__builtin_clzll(value);
+#else
+  uint32_t msb = 0;
+  while (value >>= 1) {
+    msb++;
+  }
+  return msb;
+#endif
+}
+
+/**
+ * Get the bucket a value is counted in
+ *
+ * @param value Sample value
+ * @return Bucket index
+ */
+static inline uint32_t latency_histogram_bucket(const uint64_t value) {
+  if (value < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+    return (uint32_t)value;
+  }
+  const uint32_t shift =
+      latency_histogram_msb(value) - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+  return (shift + 1U) * LATENCY_HISTOGRAM_SUB_BUCKETS +
+         (uint32_t)(value >> shift) - LATENCY_HISTOGRAM_SUB_BUCKETS;
+}
+
+/**
+ * Get the largest value counted in a bucket
+ *
+ * @param bucket Bucket index
+ * @return Highest value equivalent to the bucket
+ */
+static inline uint64_t latency_histogram_bucket_max(const uint32_t bucket) {
+  if (bucket < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+    return bucket;
+  }
+  const uint32_t shift = bucket / LATENCY_HISTOGRAM_SUB_BUCKETS - 1U;
+  const uint64_t lower = (uint64_t)(LATENCY_HISTOGRAM_SUB_BUCKETS +
+                                    bucket % LATENCY_HISTOGRAM_SUB_BUCKETS)
+                         << shift;
+  return lower + ((1ULL << shift) - 1U);
+}
+
+/**
+ * Record a sample
+ *
+ * @param h Histogram
+ * @param value Sample value
+ */
+static inline void latency_histogram_record(latency_histogram_t *const h,
+                                            const uint64_t value) {
+  h->counts[latency_histogram_bucket(value)]++;
+  h->total_count++;
+  h->sum += value;
+  if (value < h->min) {
+    h->min = value;
+  }
+  if (value > h->max) {
+    h->max = value;
+  }
+}
+
+/**
+ * Get the value at a percentile
+ *
+ * @param h Histogram
+ * @param percentile Percentile in the range [0, 100]
+ * @return Highest value equivalent to the percentile, 0 if empty
+ */
+static inline uint64_t
+latency_histogram_percentile(const latency_histogram_t *const h,
+                             const double percentile) {
+  if (h->total_count == 0) {
+    return 0;
+  }
+  uint64_t rank = (uint64_t)((percentile / 100.0) * (double)h->total_count);
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+    seen += h->counts[i];
+    if (seen >= rank) {
+      const uint64_t value = latency_histogram_bucket_max(i);
+      return (value > h->max) ? h->max : value;
+    }
+  }
+  return h->max;
+}
+
+/**
+ * Get the mean sample value
+ *
+ * @param h Histogram
+ * @return Mean, 0 if empty
+ */
+static inline uint64_t
+latency_histogram_mean(const latency_histogram_t *const h) {
+  return (h->total_count > 0) ? h->sum / h->total_count : 0;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "merge_reader.h"
+
+static inline bool merge_reader_less(const merge_reader_entry_t *const a,
+                                     const merge_reader_entry_t *const b) {
+  return a->key < b->key || (a->key == b->key && a->queue < b->queue);
+}
+
+static void merge_reader_sift_up(merge_reader_entry_t *const heap,
+                                 uint32_t index) {
+  const merge_reader_entry_t entry = heap[index];
+  while (index > 0) {
+    const uint32_t parent = (index - 1) / 2;
+    if (!merge_reader_less(&entry, &heap[parent])) {
+      break;
+    }
+    heap[index] = heap[parent];
+    index = parent;
+  }
+  heap[index] = entry;
+}
+
+static void merge_reader_sift_down(merge_reader_entry_t *const heap,
+                                   const uint32_t count, uint32_t index) {
+  const merge_reader_entry_t entry = heap[index];
+  for (;;) {
+    uint32_t child = 2 * index + 1;
+    if (child >= count) {
+      break;
+    }
+    if (child + 1 < count &&
+        merge_reader_less(&heap[child + 1], &heap[child])) {
+      child++;
+    }
+    if (!merge_reader_less(&heap[child], &entry)) {
+      break;
+    }
+    heap[index] = heap[child];
+    index = child;
+  }
+  heap[index] = entry;
+}
+
+// Move queues that are no longer empty into the heap
+static void merge_reader_refresh(merge_reader_t *const mr) {
+  uint32_t i = 0;
+  while (i < mr->idle_count) {
+    const uint32_t queue = mr->config.idle[i];
+    event_t *const evt = event_queue_get(mr->config.queues[queue]);
+    if (evt == NULL) {
+      i++;
+      continue;
+    }
+    mr->config.idle[i] = mr->config.idle[--mr->idle_count];
+    merge_reader_entry_t *const entry = &mr->config.heap[mr->heap_count];
+    entry->key = mr->config.key(evt, mr->config.key_context);
+    entry->evt = evt;
+    entry->queue = queue;
+    merge_reader_sift_up(mr->config.heap, mr->heap_count++);
+  }
+}
+
+bool merge_reader_init(merge_reader_t *const mr,
+                       merge_reader_config_t *const config) {
+  if (config->queues == NULL || config->queue_count == 0)
+    return false;
+  if (config->heap == NULL || config->idle == NULL || config->key == NULL)
+    return false;
+  memcpy(&mr->config, config, sizeof(merge_reader_config_t));
+
+  // Every queue starts idle, the first get reads their heads
+  for (uint32_t i = 0; i < config->queue_count; i++) {
+    config->idle[i] = i;
+  }
+  mr->heap_count = 0;
+  mr->idle_count = config->queue_count;
+  return true;
+}
+
+void merge_reader_poll(merge_reader_t *const mr) {
+  if (mr->idle_count > 0) {
+    merge_reader_refresh(mr);
+  }
+}
+
+event_t *merge_reader_get(merge_reader_t *const mr, uint32_t *const queue) {
+  // Empty queues are rechecked only once every other queue is drained, so a
+  // get costs O(1) however many queues are empty
+  if (mr->heap_count == 0) {
+    merge_reader_poll(mr);
+  }
+  if (mr->heap_count == 0) {
+    return NULL;
+  }
+  if (queue != NULL) {
+    *queue = mr->config.heap[0].queue;
+  }
+  return mr->config.heap[0].evt;
+}
+
+void merge_reader_pop(merge_reader_t *const mr) {
+  if (mr->heap_count == 0) {
+    return;
+  }
+  merge_reader_entry_t *const top = &mr->config.heap[0];
+  event_queue_t *const eq = mr->config.queues[top->queue];
+  event_queue_pop(eq);
+
+  // Only the queue that advanced is re-read
+  event_t *const evt = event_queue_get(eq);
+  if (evt != NULL) {
+    top->key = mr->config.key(evt, mr->config.key_context);
+    top->evt = evt;
+  } else {
+    mr->config.idle[mr->idle_count++] = top->queue;
+    mr->config.heap[0] = mr->config.heap[--mr->heap_count];
+    if (mr->heap_count == 0) {
+      return;
+    }
+  }
+  merge_reader_sift_down(mr->config.heap, mr->heap_count, 0);
+}
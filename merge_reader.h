@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MERGE_READER_H
+#define MERGE_READER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "event_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// Ordering key of an event, typically a timestamp carried in its data. The
+// data of an event compressed by its queue is encoded, decode it with
+// event_queue_read_data before reading the key.
+typedef uint64_t (*merge_reader_key_func_t)(const event_t *const evt,
+                                            void *const context);
+
+typedef struct {
+  uint64_t key;   // Key of the head event
+  event_t *evt;   // Head event of the queue
+  uint32_t queue; // Queue index
+} merge_reader_entry_t;
+
+typedef struct {
+  event_queue_t **queues;      // Queues to merge, each with a single consumer
+  uint32_t queue_count;        // Number of queues
+  merge_reader_entry_t *heap;  // queue_count entries of heap storage
+  uint32_t *idle;              // queue_count entries of empty queue storage
+  merge_reader_key_func_t key; // Reads the key of an event
+  void *key_context;           // Passed to key
+} merge_reader_config_t;
+
+typedef struct {
+  merge_reader_config_t config;
+  uint32_t heap_count; // Queues with a head event, in the heap
+  uint32_t idle_count; // Empty queues, rechecked when the heap is empty
+} merge_reader_t;
+
+/**
+ * Initialize a reader merging several queues in key order
+ *
+ *  Keeps a min-heap of the head events of the queues. Only the queue that
+ *  advanced is re-read after a pop. Empty queues are rechecked by a get
+ *  once every other queue is drained, or by merge_reader_poll.
+ *
+ * @param mr Merge Reader
+ * @param config Merge Reader Configuration
+ * @return false if the configuration is invalid
+ */
+bool merge_reader_init(merge_reader_t *const mr,
+                       merge_reader_config_t *const config);
+
+/**
+ * Recheck the queues that were empty
+ *
+ *  Costs one event_queue_get per empty queue. Call it before merge_reader_get,
+ *  not between a get and its pop, at whatever rate bounds how far a queue
+ *  that was empty can fall behind.
+ *
+ * @param mr Merge Reader
+ */
+void merge_reader_poll(merge_reader_t *const mr);
+
+/**
+ * Get the event with the lowest key across the queues
+ *
+ *  Ties are returned in queue order. The order holds across the queues that
+ *  had events when they were last read. With live producers, a get can
+ *  return an event ahead of an earlier one put on a queue that was empty, as
+ *  empty queues are only rechecked when no queue has events or by
+ *  merge_reader_poll.
+ *
+ * @param mr Merge Reader
+ * @param queue On output, index of the queue holding the event, may be NULL
+ * @return Pointer to the event - NULL if every queue is empty
+ */
+event_t *merge_reader_get(merge_reader_t *const mr, uint32_t *const queue);
+
+/**
+ * Remove the event returned by merge_reader_get
+ *
+ * @param mr Merge Reader
+ */
+void merge_reader_pop(merge_reader_t *const mr);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // MERGE_READER_H
@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "payload_pool.h"
+
+bool payload_pool_init(payload_pool_t *const pool, void *const buffer,
+                       const uint32_t buffer_len, const uint32_t payload_size) {
+  if (payload_size == 0)
+    return false;
+  if (!block_pool_init(&pool->blocks, buffer, buffer_len,
+                       PAYLOAD_HEADER_SIZE + payload_size))
+    return false;
+  pool->payload_size = pool->blocks.block_size - PAYLOAD_HEADER_SIZE;
+  return true;
+}
+
+void *payload_pool_alloc(payload_pool_t *const pool) {
+  payload_header_t *const header =
+      (payload_header_t *)block_pool_alloc(&pool->blocks);
+  if (header == NULL) {
+    return NULL;
+  }
+  header->pool = pool;
+  atomic_store(&header->refs, 1);
+  return (uint8_t *)header + PAYLOAD_HEADER_SIZE;
+}
+
+void payload_release(const void *const payload) {
+  payload_header_t *const header = payload_header(payload);
+  if (atomicFetchAdd(&header->refs, -1) == 1) {
+    block_pool_free(&header->pool->blocks, header);
+  }
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef PAYLOAD_POOL_H
+#define PAYLOAD_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "block_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef struct {
+  block_pool_t blocks;   // Blocks holding a header and the payload
+  uint32_t payload_size; // Usable bytes of each payload
+} payload_pool_t;
+
+// Precedes the payload in its block
+typedef struct {
+  payload_pool_t *pool;       // Pool to return the block to
+  volatile atomic_int_t refs; // Holders of the payload
+} payload_header_t;
+
+// Payloads start after the header, keeping pool alignment
+#define PAYLOAD_HEADER_SIZE                                                    \
+  ((sizeof(payload_header_t) + BLOCK_POOL_ALIGNMENT - 1) &                     \
+   ~(size_t)(BLOCK_POOL_ALIGNMENT - 1))
+
+/**
+ * Initialize a pool of reference counted payloads
+ *
+ *  A payload is shared by every queue it is put on, and returned to the pool
+ *  once the last holder releases it.
+ *
+ * @param pool Payload pool
+ * @param buffer Block of memory to carve into payloads, 8 byte aligned
+ * @param buffer_len Size of the memory block
+ * @param payload_size Usable size of each payload
+ * @return false if the buffer cannot hold a payload
+ */
+bool payload_pool_init(payload_pool_t *const pool, void *const buffer,
+                       const uint32_t buffer_len, const uint32_t payload_size);
+
+/**
+ * Take a payload from the pool, holding one reference
+ *
+ * @param pool Payload pool
+ * @return Pointer to payload_size bytes, NULL if the pool is empty
+ */
+void *payload_pool_alloc(payload_pool_t *const pool);
+
+/**
+ * Get the header of a payload
+ *
+ * @param payload Payload taken from a pool
+ * @return Payload header
+ */
+static inline payload_header_t *payload_header(const void *const payload) {
+  return (payload_header_t *)((const uint8_t *)payload - PAYLOAD_HEADER_SIZE);
+}
+
+/**
+ * Take another reference to a payload
+ *
+ * @param payload Payload taken from a pool
+ */
+static inline void payload_ref(const void *const payload) {
+  atomicFetchAdd(&payload_header(payload)->refs, 1);
+}
+
+/**
+ * Drop a reference to a payload, returning it to its pool after the last
+ *
+ * @param payload Payload taken from a pool
+ */
+void payload_release(const void *const payload);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // PAYLOAD_POOL_H
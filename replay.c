@@ -0,0 +1,277 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "event_compress.h"
+#include "event_queue.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Replays a capture written through event_queue_config_t.capture through an
+// event queue with a producer and a consumer thread, reporting throughput and
+// put to pop latency. The queue always uses atomics, as the producer and the
+// consumer run on separate threads.
+
+#define MAX_EVENT_DATA_LEN (uint32_t)(1024 * 1024)
+
+typedef struct {
+  event_capture_record_t record;
+  uint8_t *event_data;
+} replay_event_t;
+
+typedef struct {
+  event_queue_t *eq;
+  uint64_t event_count;
+} consumer_args_t;
+
+static void *consumer(void *arg) {
+  consumer_args_t *const args = (consumer_args_t *)arg;
+  uint64_t popped = 0;
+  while (popped < args->event_count) {
+    if (event_queue_get(args->eq) != NULL) {
+      event_queue_pop(args->eq);
+      popped++;
+    } else {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+static volatile atomic_int_t replay_lock_word;
+
+static void replay_lock(void) {
+  int expected = 0;
+  while (!atomic_compare_exchange_weak(&replay_lock_word, &expected, 1)) {
+    expected = 0;
+    sched_yield();
+  }
+}
+
+static void replay_unlock(void) { atomic_store(&replay_lock_word, 0); }
+
+static void free_events(replay_event_t *const events,
+                        const uint64_t event_count) {
+  for (uint64_t i = 0; i < event_count; i++) {
+    free(events[i].event_data);
+  }
+  free(events);
+}
+
+static replay_event_t *load_capture(const char *const path,
+                                    uint64_t *const event_count) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror(path);
+    return NULL;
+  }
+
+  event_capture_t cap;
+  if (!event_capture_open_read(&cap, file)) {
+    fprintf(stderr, "%s: not an event capture\n", path);
+    fclose(file);
+    return NULL;
+  }
+
+  static uint8_t event_data[MAX_EVENT_DATA_LEN];
+  uint64_t capacity = 1024;
+  replay_event_t *events = malloc(capacity * sizeof(replay_event_t));
+  *event_count = 0;
+  if (events == NULL) {
+    fprintf(stderr, "%s: out of memory\n", path);
+    fclose(file);
+    return NULL;
+  }
+  bool out_of_memory = false;
+  while (event_capture_read(&cap, &events[*event_count].record, event_data,
+                            sizeof(event_data))) {
+    replay_event_t *const event = &events[*event_count];
+    event->event_data = malloc(event->record.event_data_length + 1);
+    if (event->event_data == NULL) {
+      out_of_memory = true;
+      break;
+    }
+    memcpy(event->event_data, event_data, event->record.event_data_length);
+    if (++(*event_count) == capacity) {
+      // Keep the old block until the larger one is allocated
+      replay_event_t *const grown =
+          realloc(events, 2 * capacity * sizeof(replay_event_t));
+      if (grown == NULL) {
+        out_of_memory = true;
+        break;
+      }
+      events = grown;
+      capacity *= 2;
+    }
+  }
+  fclose(file);
+
+  if (out_of_memory) {
+    fprintf(stderr, "%s: out of memory after %llu records\n", path,
+            (unsigned long long)*event_count);
+    free_events(events, *event_count);
+    return NULL;
+  }
+  if (cap.error) {
+    fprintf(stderr, "%s: truncated or corrupt after %llu records\n", path,
+            (unsigned long long)*event_count);
+  }
+  return events;
+}
+
+static void usage(const char *const name) {
+  fprintf(stderr,
+          "usage: %s [--buffer-size bytes] [--alignment bytes] [--locked] "
+          "[--copy-stream bytes] [--compress bytes] [--clock monotonic|cycles] "
+          "[--max-speed] capture\n",
+          name);
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t buffer_size = 64 * 1024;
+  uint32_t alignment = 4;
+  bool locked = false;
+  uint32_t copy_stream_threshold = 0;
+  uint32_t compress_threshold = 0;
+  event_clock_source_t clock = EVENT_CLOCK_MONOTONIC;
+  bool max_speed = false;
+  const char *path = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--buffer-size") == 0 && i + 1 < argc) {
+      buffer_size = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--alignment") == 0 && i + 1 < argc) {
+      alignment = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--locked") == 0) {
+      locked = true;
+    } else if (strcmp(argv[i], "--copy-stream") == 0 && i + 1 < argc) {
+      copy_stream_threshold = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--compress") == 0 && i + 1 < argc) {
+      compress_threshold = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--clock") == 0 && i + 1 < argc &&
+               (strcmp(argv[i + 1], "monotonic") == 0 ||
+                strcmp(argv[i + 1], "cycles") == 0)) {
+      clock = (strcmp(argv[++i], "cycles") == 0) ? EVENT_CLOCK_CYCLES
+                                                 : EVENT_CLOCK_MONOTONIC;
+    } else if (strcmp(argv[i], "--max-speed") == 0) {
+      max_speed = true;
+    } else if (argv[i][0] != '-' && path == NULL) {
+      path = argv[i];
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (path == NULL) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  uint64_t event_count;
+  replay_event_t *events = load_capture(path, &event_count);
+  if (events == NULL) {
+    return 1;
+  }
+
+  uint8_t *buffer = malloc(buffer_size);
+  latency_histogram_t histogram;
+  event_queue_t eq;
+  event_queue_config_t eq_config = {
+      .buffer = buffer,
+      .buffer_len = buffer_size,
+      .alignment = alignment,
+      .use_atomics = true,
+      .lock = locked ? replay_lock : NULL,
+      .unlock = locked ? replay_unlock : NULL,
+      .latency_histogram = &histogram,
+      .clock = clock,
+      .copy_stream_threshold = copy_stream_threshold,
+      .compress_threshold = compress_threshold};
+  if (buffer == NULL || !event_queue_init(&eq, &eq_config)) {
+    fprintf(stderr, "invalid queue configuration\n");
+    return 1;
+  }
+
+  // An event that can never fit would stall the producer
+  for (uint64_t i = 0; i < event_count; i++) {
+    uint32_t event_data_len = events[i].record.event_data_length;
+    if (compress_threshold && event_data_len >= compress_threshold) {
+      // Reserved at its largest encoding, behind the original size
+      event_data_len = event_compress_bound(event_data_len) + sizeof(uint64_t);
+    }
+    if (event_queue_put_size(&eq, event_data_len) > buffer_size) {
+      fprintf(stderr, "event %llu does not fit in a %u byte buffer\n",
+              (unsigned long long)i, buffer_size);
+      return 1;
+    }
+  }
+
+  consumer_args_t args = {.eq = &eq, .event_count = event_count};
+  pthread_t consumer_thread;
+  pthread_create(&consumer_thread, NULL, consumer, &args);
+
+  uint64_t bytes = 0;
+  uint64_t full_retries = 0;
+  const uint64_t start = event_clock_monotonic_ns();
+  uint64_t due = start;
+  for (uint64_t i = 0; i < event_count; i++) {
+    replay_event_t *const event = &events[i];
+    if (!max_speed) {
+      due += event->record.delta_ns;
+      while (event_clock_monotonic_ns() < due) {
+        sched_yield();
+      }
+    }
+    while (!event_queue_put(&eq, event->record.event_id, event->event_data,
+                            event->record.event_data_length)) {
+      full_retries++;
+      sched_yield();
+    }
+    bytes += event->record.event_data_length;
+  }
+  pthread_join(consumer_thread, NULL);
+  const uint64_t elapsed = event_clock_monotonic_ns() - start;
+
+  const double seconds = (double)elapsed / 1e9;
+  printf("events        %llu\n", (unsigned long long)event_count);
+  printf("bytes         %llu\n", (unsigned long long)bytes);
+  printf("elapsed       %.3f s\n", seconds);
+  printf("throughput    %.0f events/s, %.1f MB/s\n",
+         (double)event_count / seconds, (double)bytes / seconds / 1e6);
+  printf("full retries  %llu\n", (unsigned long long)full_retries);
+  printf("high water    %u of %u bytes\n", eq._cb.high_water_fill_count,
+         buffer_size);
+  printf("latency %-5s mean %llu p50 %llu p99 %llu p99.9 %llu max %llu\n",
+         (clock == EVENT_CLOCK_CYCLES) ? "ticks" : "ns",
+         (unsigned long long)latency_histogram_mean(&histogram),
+         (unsigned long long)latency_histogram_percentile(&histogram, 50.0),
+         (unsigned long long)latency_histogram_percentile(&histogram, 99.0),
+         (unsigned long long)latency_histogram_percentile(&histogram, 99.9),
+         (unsigned long long)histogram.max);
+
+  for (uint64_t i = 0; i < event_count; i++) {
+    free(events[i].event_data);
+  }
+  free(events);
+  free(buffer);
+  return 0;
+}
@@ -0,0 +1,228 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "rpc_channel.h"
+
+// Slot state: generation above the abandoned and parked bits and the phase
+#define RPC_PHASE_MASK 3
+#define RPC_PHASE_FREE 0
+#define RPC_PHASE_PENDING 1
+#define RPC_PHASE_REPLYING 2
+#define RPC_PHASE_REPLIED 3
+#define RPC_PARKED 4
+#define RPC_ABANDONED 8
+#define RPC_GENERATION_SHIFT 4
+#define RPC_GENERATION_MASK 0xFFFFU
+
+static inline int rpc_state(const uint32_t generation, const int phase) {
+  return (int)((generation & RPC_GENERATION_MASK) << RPC_GENERATION_SHIFT) |
+         phase;
+}
+
+static inline uint32_t rpc_state_generation(const int state) {
+  return ((uint32_t)state >> RPC_GENERATION_SHIFT) & RPC_GENERATION_MASK;
+}
+
+static inline rpc_handle_t rpc_handle(const uint32_t index,
+                                      const uint32_t generation) {
+  return (generation << RPC_CHANNEL_SLOT_BITS) | index;
+}
+
+static inline uint32_t rpc_handle_generation(const rpc_handle_t handle) {
+  return (handle >> RPC_CHANNEL_SLOT_BITS) & RPC_GENERATION_MASK;
+}
+
+static inline rpc_channel_slot_t *rpc_slot(rpc_channel_t *const ch,
+                                           const rpc_handle_t handle) {
+  return &ch->config.slots[handle & (RPC_CHANNEL_MAX_SLOTS - 1)];
+}
+
+// Free a slot, moving it to the next generation so stale handles miss it
+static inline void rpc_slot_free(rpc_channel_slot_t *const slot,
+                                 const rpc_handle_t handle) {
+  atomic_store(&slot->state, rpc_state(rpc_handle_generation(handle) + 1,
+                                       RPC_PHASE_FREE));
+}
+
+bool rpc_channel_init(rpc_channel_t *const ch,
+                      rpc_channel_config_t *const config) {
+  if (config->slots == NULL || config->reply_buffer == NULL)
+    return false;
+  if (config->slot_count == 0 || config->slot_count > RPC_CHANNEL_MAX_SLOTS)
+    return false;
+  memcpy(&ch->config, config, sizeof(rpc_channel_config_t));
+
+  event_queue_config_t eq_config = {.buffer = config->request_buffer,
+                                    .buffer_len = config->request_buffer_len,
+                                    .alignment = config->alignment,
+                                    .use_atomics = true,
+                                    .lock = config->lock,
+                                    .unlock = config->unlock};
+  if (!event_queue_init(&ch->requests, &eq_config))
+    return false;
+
+  for (uint32_t i = 0; i < config->slot_count; i++) {
+    rpc_channel_slot_t *const slot = &config->slots[i];
+    atomic_store(&slot->state, rpc_state(0, RPC_PHASE_FREE));
+    slot->reply_length = 0;
+    slot->reply = (uint8_t *)config->reply_buffer +
+                  (size_t)i * config->reply_capacity;
+  }
+  atomic_store(&ch->_next_slot, 0);
+  return true;
+}
+
+bool rpc_channel_call(rpc_channel_t *const ch, void *const request,
+                      const uint32_t request_len, rpc_handle_t *const handle) {
+  // Claim a free slot, starting where the last search left off
+  const uint32_t start =
+      (uint32_t)atomicFetchAdd(&ch->_next_slot, 1) % ch->config.slot_count;
+  rpc_channel_slot_t *slot = NULL;
+  for (uint32_t i = 0; i < ch->config.slot_count && slot == NULL; i++) {
+    const uint32_t index = (start + i) % ch->config.slot_count;
+    rpc_channel_slot_t *const candidate = &ch->config.slots[index];
+    int state = atomic_load(&candidate->state);
+    if ((state & RPC_PHASE_MASK) == RPC_PHASE_FREE &&
+        atomic_compare_exchange_strong(
+            &candidate->state, &state,
+            rpc_state(rpc_state_generation(state), RPC_PHASE_PENDING))) {
+      *handle = rpc_handle(index, rpc_state_generation(state));
+      slot = candidate;
+    }
+  }
+  if (slot == NULL) {
+    return false;
+  }
+
+  if (!event_queue_put(&ch->requests, *handle, request, request_len)) {
+    rpc_slot_free(slot, *handle);
+    return false;
+  }
+  return true;
+}
+
+event_t *rpc_channel_get_request(rpc_channel_t *const ch) {
+  return event_queue_get(&ch->requests);
+}
+
+void rpc_channel_pop_request(rpc_channel_t *const ch) {
+  event_queue_pop(&ch->requests);
+}
+
+void *rpc_channel_reply_buffer(rpc_channel_t *const ch,
+                               const rpc_handle_t handle) {
+  rpc_channel_slot_t *const slot = rpc_slot(ch, handle);
+  const uint32_t generation = rpc_handle_generation(handle);
+  int state = atomic_load(&slot->state);
+
+  // Keep the parked bit, so the commit knows to wake the caller
+  while (rpc_state_generation(state) == generation &&
+         (state & RPC_PHASE_MASK) == RPC_PHASE_PENDING) {
+    if (atomic_compare_exchange_weak(
+            &slot->state, &state,
+            (state & ~RPC_PHASE_MASK) | RPC_PHASE_REPLYING)) {
+      return slot->reply;
+    }
+  }
+  return NULL;
+}
+
+void rpc_channel_reply_commit(rpc_channel_t *const ch,
+                              const rpc_handle_t handle,
+                              const uint32_t reply_len) {
+  rpc_channel_slot_t *const slot = rpc_slot(ch, handle);
+  slot->reply_length = reply_len;
+  const int state = atomic_exchange(
+      &slot->state,
+      rpc_state(rpc_handle_generation(handle), RPC_PHASE_REPLIED));
+  if (state & RPC_ABANDONED) {
+    // The caller gave up while the reply was built
+    rpc_slot_free(slot, handle);
+  } else if (state & RPC_PARKED) {
+    // Only the caller of this request parks on its slot
+    event_wait_wake(&slot->state);
+  }
+}
+
+bool rpc_channel_reply(rpc_channel_t *const ch, const rpc_handle_t handle,
+                       const void *const reply, const uint32_t reply_len) {
+  if (reply_len > ch->config.reply_capacity) {
+    return false;
+  }
+  void *const buffer = rpc_channel_reply_buffer(ch, handle);
+  if (buffer == NULL) {
+    return false;
+  }
+  memcpy(buffer, reply, reply_len);
+  rpc_channel_reply_commit(ch, handle, reply_len);
+  return true;
+}
+
+bool rpc_channel_wait(rpc_channel_t *const ch, const rpc_handle_t handle,
+                      const uint64_t timeout_ns, void **const reply,
+                      uint32_t *const reply_len) {
+  rpc_channel_slot_t *const slot = rpc_slot(ch, handle);
+  const uint64_t now = event_clock_monotonic_ns();
+  const uint64_t deadline = (timeout_ns < EVENT_WAIT_FOREVER - now)
+                                ? now + timeout_ns
+                                : EVENT_WAIT_FOREVER;
+
+  for (uint32_t attempt = 0;; attempt++) {
+    int state = atomic_load(&slot->state);
+    if ((state & RPC_PHASE_MASK) == RPC_PHASE_REPLIED) {
+      break;
+    }
+    if (event_wait_parks(&ch->config.wait, attempt) &&
+        !(state & RPC_PARKED)) {
+      // Tell the server to wake this slot, then recheck
+      if (!atomic_compare_exchange_strong(&slot->state, &state,
+                                          state | RPC_PARKED)) {
+        continue;
+      }
+      state |= RPC_PARKED;
+    }
+    if (!event_wait_step(&ch->config.wait, attempt, &slot->state, state,
+                         deadline)) {
+      // Give up, a reply being built frees the slot once committed
+      state = atomic_load(&slot->state);
+      const int phase = state & RPC_PHASE_MASK;
+      if (phase == RPC_PHASE_PENDING &&
+          atomic_compare_exchange_strong(
+              &slot->state, &state,
+              rpc_state(rpc_handle_generation(handle) + 1, RPC_PHASE_FREE))) {
+        return false;
+      }
+      if (phase == RPC_PHASE_REPLYING &&
+          atomic_compare_exchange_strong(&slot->state, &state,
+                                         state | RPC_ABANDONED)) {
+        return false;
+      }
+    }
+  }
+
+  *reply = slot->reply;
+  *reply_len = slot->reply_length;
+  return true;
+}
+
+void rpc_channel_release(rpc_channel_t *const ch, const rpc_handle_t handle) {
+  rpc_slot_free(rpc_slot(ch, handle), handle);
+}
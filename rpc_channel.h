@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RPC_CHANNEL_H
+#define RPC_CHANNEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "event_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// Handles carry the slot index in the low bits and its generation above them
+#define RPC_CHANNEL_SLOT_BITS 16
+#define RPC_CHANNEL_MAX_SLOTS (1U << RPC_CHANNEL_SLOT_BITS)
+
+typedef event_id_t rpc_handle_t;
+
+typedef struct {
+  volatile atomic_int_t state; // Generation, phase and parked waiter
+  uint32_t reply_length;       // Size of the reply
+  uint8_t *reply;              // reply_capacity bytes of reply memory
+} rpc_channel_slot_t;
+
+typedef struct {
+  void *request_buffer;        // Request ring memory
+  uint32_t request_buffer_len; // Size of request ring memory
+  uint32_t alignment;          // Request alignment
+  lock_unlock_func_t lock;     // Optional lock, for multiple callers
+  lock_unlock_func_t unlock;   // Optional unlock, for multiple callers
+  rpc_channel_slot_t *slots;   // Completion slots, one per call in flight
+  uint32_t slot_count;         // Number of slots
+  void *reply_buffer;          // slot_count * reply_capacity bytes
+  uint32_t reply_capacity;     // Largest reply
+  event_wait_strategy_t wait;  // How callers wait for replies
+} rpc_channel_config_t;
+
+typedef struct {
+  rpc_channel_config_t config;
+  event_queue_t requests;           // Requests, event id is the handle
+  volatile atomic_int_t _next_slot; // Where the next slot search starts
+} rpc_channel_t;
+
+/**
+ * Initialize a request/response channel
+ *
+ *  Requests travel on an event queue. Each call holds a preallocated
+ *  completion slot until the caller releases it, and the reply is written
+ *  straight into that slot.
+ *
+ * @param ch RPC Channel
+ * @param config RPC Channel Configuration
+ * @return false if the configuration is invalid
+ */
+bool rpc_channel_init(rpc_channel_t *const ch,
+                      rpc_channel_config_t *const config);
+
+/**
+ * Send a request
+ *
+ * @param ch RPC Channel
+ * @param request Request data
+ * @param request_len Size of request data
+ * @param handle On output, handle to wait on, also the event id the server
+ * sees
+ * @return false if no slot is free or the request queue is full
+ */
+bool rpc_channel_call(rpc_channel_t *const ch, void *const request,
+                      const uint32_t request_len, rpc_handle_t *const handle);
+
+/**
+ * Get the next request, for the server
+ *
+ * @param ch RPC Channel
+ * @return Request event, its event id is the handle to reply to - NULL if none
+ */
+event_t *rpc_channel_get_request(rpc_channel_t *const ch);
+
+/**
+ * Remove the request returned by rpc_channel_get_request
+ *
+ * @param ch RPC Channel
+ */
+void rpc_channel_pop_request(rpc_channel_t *const ch);
+
+/**
+ * Claim the reply memory of a call, to build the reply in place
+ *
+ *  Must be followed by rpc_channel_reply_commit.
+ *
+ * @param ch RPC Channel
+ * @param handle Handle of the request
+ * @return reply_capacity bytes of reply memory, NULL if the caller gave up
+ */
+void *rpc_channel_reply_buffer(rpc_channel_t *const ch,
+                               const rpc_handle_t handle);
+
+/**
+ * Complete a reply built with rpc_channel_reply_buffer, waking the caller
+ *
+ * @param ch RPC Channel
+ * @param handle Handle of the request
+ * @param reply_len Size of the reply
+ */
+void rpc_channel_reply_commit(rpc_channel_t *const ch,
+                              const rpc_handle_t handle,
+                              const uint32_t reply_len);
+
+/**
+ * Reply to a request, waking the caller
+ *
+ * @param ch RPC Channel
+ * @param handle Handle of the request
+ * @param reply Reply data
+ * @param reply_len Size of the reply
+ * @return false if the reply is too large or the caller gave up
+ */
+bool rpc_channel_reply(rpc_channel_t *const ch, const rpc_handle_t handle,
+                       const void *const reply, const uint32_t reply_len);
+
+/**
+ * Wait for the reply to a call
+ *
+ *  On timeout the call is abandoned and a late reply is dropped. Its slot is
+ *  freed at once, or by rpc_channel_reply_commit if the server was already
+ *  building the reply. On success the reply stays valid until
+ *  rpc_channel_release.
+ *
+ * @param ch RPC Channel
+ * @param handle Handle from rpc_channel_call
+ * @param timeout_ns Time to wait, EVENT_WAIT_FOREVER to wait indefinitely
+ * @param reply On output, the reply in the completion slot
+ * @param reply_len On output, size of the reply
+ * @return false if no reply arrived in time
+ */
+bool rpc_channel_wait(rpc_channel_t *const ch, const rpc_handle_t handle,
+                      const uint64_t timeout_ns, void **const reply,
+                      uint32_t *const reply_len);
+
+/**
+ * Free the completion slot of a call once its reply has been read
+ *
+ * @param ch RPC Channel
+ * @param handle Handle from rpc_channel_call
+ */
+void rpc_channel_release(rpc_channel_t *const ch, const rpc_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // RPC_CHANNEL_H
@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "segmented_queue.h"
+
+// Ring memory starts after the segment header, keeping pool alignment
+#define SEGMENT_HEADER_SIZE                                                    \
+  ((sizeof(segmented_queue_segment_t) + BLOCK_POOL_ALIGNMENT - 1) &            \
+   ~(size_t)(BLOCK_POOL_ALIGNMENT - 1))
+
+static segmented_queue_segment_t *
+segmented_queue_add_segment(segmented_queue_t *const sq) {
+  if (sq->config.max_segments &&
+      atomic_load(&sq->segment_count) >= (int)sq->config.max_segments) {
+    return NULL;
+  }
+  segmented_queue_segment_t *const seg =
+      (segmented_queue_segment_t *)block_pool_alloc(sq->config.pool);
+  if (seg == NULL) {
+    return NULL;
+  }
+
+  event_queue_config_t eq_config = {
+      .buffer = (uint8_t *)seg + SEGMENT_HEADER_SIZE,
+      .buffer_len = sq->config.pool->block_size - SEGMENT_HEADER_SIZE,
+      .alignment = sq->config.alignment,
+      .use_atomics = sq->config.use_atomics,
+      .lock = NULL,
+      .unlock = NULL,
+      // Records never read unwritten bytes, skip zeroing in the burst path
+      .skip_clear = true};
+  event_queue_init(&seg->eq, &eq_config);
+  atomic_store(&seg->next, 0);
+  atomicFetchAdd(&sq->segment_count, 1);
+  return seg;
+}
+
+static void segmented_queue_remove_segment(segmented_queue_t *const sq,
+                                           segmented_queue_segment_t *seg) {
+  atomicFetchAdd(&sq->segment_count, -1);
+  block_pool_free(sq->config.pool, seg);
+}
+
+bool segmented_queue_init(segmented_queue_t *const sq,
+                          segmented_queue_config_t *const config) {
+  if (config->pool == NULL)
+    return false;
+  if (config->pool->block_size <= SEGMENT_HEADER_SIZE)
+    return false;
+  memcpy(&sq->config, config, sizeof(segmented_queue_config_t));
+  atomic_store(&sq->segment_count, 0);
+  sq->head = sq->tail = segmented_queue_add_segment(sq);
+  return sq->head != NULL;
+}
+
+void segmented_queue_deinit(segmented_queue_t *const sq) {
+  while (sq->tail != NULL) {
+    segmented_queue_segment_t *const seg = sq->tail;
+    const int next = atomic_load(&seg->next);
+    sq->tail = next ? (segmented_queue_segment_t *)block_pool_block(
+                          sq->config.pool, (uint32_t)next - 1)
+                    : NULL;
+    segmented_queue_remove_segment(sq, seg);
+  }
+  sq->head = NULL;
+}
+
+bool segmented_queue_put(segmented_queue_t *const sq, const event_id_t event_id,
+                         void *const event_data,
+                         const uint32_t event_data_len) {
+  bool placed;
+
+  // If locking function present, lock
+  if (sq->config.lock) {
+    sq->config.lock();
+  }
+
+  placed = event_queue_put(&sq->head->eq, event_id, event_data, event_data_len);
+  if (!placed) {
+    // The head segment is full, continue in a new segment
+    segmented_queue_segment_t *const seg = segmented_queue_add_segment(sq);
+    if (seg != NULL) {
+      placed = event_queue_put(&seg->eq, event_id, event_data, event_data_len);
+      if (placed) {
+        // Publish the segment only once the event is in it. The consumer
+        // never retires a segment before it has seen the link.
+        atomic_store(&sq->head->next,
+                     (int)block_pool_index(sq->config.pool, seg) + 1);
+        sq->head = seg;
+      } else {
+        // Event larger than a segment
+        segmented_queue_remove_segment(sq, seg);
+      }
+    }
+  }
+
+  // If unlock function present, unlock
+  if (sq->config.unlock) {
+    sq->config.unlock();
+  }
+
+  return placed;
+}
+
+event_t *segmented_queue_get(segmented_queue_t *const sq) {
+  for (;;) {
+    segmented_queue_segment_t *const seg = sq->tail;
+    event_t *evt = event_queue_get(&seg->eq);
+    if (evt != NULL) {
+      return evt;
+    }
+
+    const int next = atomic_load(&seg->next);
+    if (next == 0) {
+      return NULL;
+    }
+
+    // The producer finished with this segment before linking the next one,
+    // check again for events written before the link was observed.
+    evt = event_queue_get(&seg->eq);
+    if (evt != NULL) {
+      return evt;
+    }
+
+    sq->tail = (segmented_queue_segment_t *)block_pool_block(sq->config.pool,
+                                                             (uint32_t)next - 1);
+    segmented_queue_remove_segment(sq, seg);
+  }
+}
+
+void segmented_queue_pop(segmented_queue_t *const sq) {
+  if (segmented_queue_get(sq) != NULL) {
+    event_queue_pop(&sq->tail->eq);
+  }
+}
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef SEGMENTED_QUEUE_H
+#define SEGMENTED_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "block_pool.h"
+#include "event_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef struct {
+  event_queue_t eq;           // Event queue over the rest of the block
+  volatile atomic_int_t next; // Pool index + 1 of the next segment, 0 if none
+} segmented_queue_segment_t;
+
+typedef struct {
+  block_pool_t *pool;        // Shared pool of segments
+  uint32_t alignment;        // Event alignment within segments
+  bool use_atomics;          // Single producer, single consumer
+  uint32_t max_segments;     // Limit on segments held, 0 for no limit
+  lock_unlock_func_t lock;   // Optional producer lock
+  lock_unlock_func_t unlock; // Optional producer unlock
+} segmented_queue_config_t;
+
+typedef struct {
+  segmented_queue_config_t config;
+  segmented_queue_segment_t *head;     // Segment being written
+  segmented_queue_segment_t *tail;     // Segment being read
+  volatile atomic_int_t segment_count; // Number of segments held
+} segmented_queue_t;
+
+/**
+ * Initialize a segmented event queue
+ *
+ *  The queue is a chain of event queues, each held in a block of the segment
+ *  pool. A segment is taken from the pool when the head segment fills, and
+ *  returned to the pool once the consumer drains it. Many queues can share
+ *  one pool. Events must fit in a single segment.
+ *
+ * @param sq Segmented Queue
+ * @param config Segmented Queue Configuration
+ * @return false if the pool has no free segment
+ */
+bool segmented_queue_init(segmented_queue_t *const sq,
+                          segmented_queue_config_t *const config);
+
+/**
+ * Return all segments to the pool
+ *
+ * @param sq Segmented Queue
+ */
+void segmented_queue_deinit(segmented_queue_t *const sq);
+
+/**
+ * Put an event on the segmented queue
+ *
+ * @param sq Segmented Queue
+ * @param event_id Event identifier
+ * @param event_data Data to accompany event
+ * @param event_data_len Size of event data
+ * @return false if no segment could be added, or the event cannot fit in one
+ */
+bool segmented_queue_put(segmented_queue_t *const sq, const event_id_t event_id,
+                         void *const event_data, const uint32_t event_data_len);
+
+/**
+ * Get an event off the segmented queue
+ *
+ * @param sq Segmented Queue
+ * @return Pointer to the event - NULL if no event
+ */
+event_t *segmented_queue_get(segmented_queue_t *const sq);
+
+/**
+ * Remove an event from the segmented queue
+ *
+ * @param sq Segmented Queue
+ */
+void segmented_queue_pop(segmented_queue_t *const sq);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // SEGMENTED_QUEUE_H
@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "slot_queue.h"
+
+bool slot_queue_init(slot_queue_t *const sq,
+                     slot_queue_config_t *const config) {
+  if (config->buffer == NULL)
+    return false;
+  if (config->slot_size == 0)
+    return false;
+  memcpy(&sq->config, config, sizeof(slot_queue_config_t));
+  sq->slot_stride = config->slot_size;
+  if (config->alignment > 0) {
+    sq->slot_stride += (config->alignment - config->slot_size %
+                                                config->alignment) %
+                       config->alignment;
+  }
+  const uint32_t slot_count = config->buffer_len / sq->slot_stride;
+  if (slot_count == 0)
+    return false;
+
+  // The circular buffer counts slots rather than bytes
+  circular_buffer_init(&sq->_cb, config->buffer, slot_count,
+                       config->use_atomics);
+  return true;
+}
+
+void slot_queue_clear(slot_queue_t *const sq) {
+  circular_buffer_clear(&sq->_cb);
+}
+
+bool slot_queue_put(slot_queue_t *const sq, const void *const event_data) {
+  uint32_t free_slots;
+
+  // If locking function present, lock
+  if (sq->config.lock) {
+    sq->config.lock();
+  }
+
+  circular_buffer_head(&sq->_cb, &free_slots);
+  const bool placed = free_slots > 0;
+  if (placed) {
+    event_copy((uint8_t *)sq->config.buffer + sq->_cb.head * sq->slot_stride,
+               event_data, sq->config.slot_size, 0);
+    circular_buffer_produce(&sq->_cb, 1);
+  }
+
+  // If unlock function present, unlock
+  if (sq->config.unlock) {
+    sq->config.unlock();
+  }
+
+  return placed;
+}
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef SLOT_QUEUE_H
+#define SLOT_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "circular_buffer.h"
+#include "event_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef struct {
+  void *buffer;              // Slot memory
+  uint32_t buffer_len;       // Size of slot memory
+  uint32_t slot_size;        // Size of every event
+  uint32_t alignment;        // Slot alignment, 0 to pack slots
+  bool use_atomics;          // Single producer, single consumer
+  lock_unlock_func_t lock;   // Optional producer lock
+  lock_unlock_func_t unlock; // Optional producer unlock
+} slot_queue_config_t;
+
+typedef struct {
+  slot_queue_config_t config;
+  uint32_t slot_stride;  // Slot size rounded up to the alignment
+  circular_buffer_t _cb; // Head, tail and fill count in slots
+} slot_queue_t;
+
+/**
+ * Initialize a fixed size slot queue
+ *
+ *  Every event is slot_size bytes, stored in an array of slots without
+ *  markers, headers or padding.
+ *
+ * @param sq Slot Queue
+ * @param config Slot Queue Configuration
+ * @return false if the buffer cannot hold a slot
+ */
+bool slot_queue_init(slot_queue_t *const sq,
+                     slot_queue_config_t *const config);
+
+/**
+ * Clear the slot queue
+ *
+ * @param sq Slot Queue
+ */
+void slot_queue_clear(slot_queue_t *const sq);
+
+/**
+ * Put an event on the slot queue
+ *
+ * @param sq Slot Queue
+ * @param event_data slot_size bytes of event data
+ * @return false if the queue is full
+ */
+bool slot_queue_put(slot_queue_t *const sq, const void *const event_data);
+
+/**
+ * Get the oldest event on the slot queue
+ *
+ * @param sq Slot Queue
+ * @return Pointer to the slot_size bytes of the event - NULL if no event
+ */
+static inline void *slot_queue_get(slot_queue_t *const sq) {
+  uint32_t available_slots;
+  if (circular_buffer_tail(&sq->_cb, &available_slots) == NULL) {
+    return NULL;
+  }
+  return (uint8_t *)sq->config.buffer + sq->_cb.tail * sq->slot_stride;
+}
+
+/**
+ * Remove an event from the slot queue
+ *
+ * @param sq Slot Queue
+ */
+static inline void slot_queue_pop(slot_queue_t *const sq) {
+  if (sq->_cb.fill_count > 0) {
+    circular_buffer_consume(&sq->_cb, 1);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // SLOT_QUEUE_H
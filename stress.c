@@ -0,0 +1,366 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#if defined(__linux__)
+#define _GNU_SOURCE // pthread_setaffinity_np
+#endif
+#include "event_queue.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Runs producer and consumer threads against one event queue, checking the
+// sequence and contents of every payload, and compares throughput against a
+// stored baseline. Single producer mode exercises the use_atomics path,
+// multiple producers share the queue through the lock callbacks.
+
+#define MAX_PRODUCERS 64
+#define MIN_EVENT_DATA_LEN (uint32_t)(sizeof(uint32_t) + sizeof(uint64_t))
+
+typedef struct {
+  event_queue_t *eq;
+  uint32_t producer;
+  uint64_t event_count;
+  uint32_t max_size;
+  int cpu;
+  uint64_t full_retries;
+} producer_args_t;
+
+typedef struct {
+  event_queue_t *eq;
+  uint32_t producer_count;
+  uint64_t event_count;
+  uint32_t max_size;
+  int cpu;
+  volatile atomic_int_t producers_done; // Set once every producer has joined
+  uint64_t next_seq[MAX_PRODUCERS];     // Next sequence due from each producer
+  uint64_t errors;
+  uint64_t missing;
+} consumer_args_t;
+
+static volatile atomic_int_t producer_lock_word;
+
+static void producer_lock(void) {
+  int expected = 0;
+  while (!atomic_compare_exchange_weak(&producer_lock_word, &expected, 1)) {
+    expected = 0;
+    sched_yield();
+  }
+}
+
+static void producer_unlock(void) { atomic_store(&producer_lock_word, 0); }
+
+static void pin(const int cpu) {
+#if defined(__linux__)
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+      fprintf(stderr, "cannot pin to cpu %d\n", cpu);
+    }
+  }
+#else
+  (void)cpu;
+#endif
+}
+
+// Payload length and contents are derived from the producer and sequence
+static uint32_t payload_length(const uint32_t producer, const uint64_t seq,
+                               const uint32_t max_size) {
+  uint64_t x = (seq + 1) * 0x9E3779B97F4A7C15ULL ^ producer;
+  x ^= x >> 29;
+  return MIN_EVENT_DATA_LEN +
+         (uint32_t)(x % (max_size - MIN_EVENT_DATA_LEN + 1));
+}
+
+static inline uint8_t payload_byte(const uint64_t seq, const uint32_t i) {
+  return (uint8_t)(seq * 31 + i);
+}
+
+static void *producer(void *arg) {
+  producer_args_t *const args = (producer_args_t *)arg;
+  pin(args->cpu);
+  uint8_t *const data = malloc(args->max_size);
+  for (uint64_t seq = 0; seq < args->event_count; seq++) {
+    const uint32_t len = payload_length(args->producer, seq, args->max_size);
+    memcpy(data, &args->producer, sizeof(uint32_t));
+    memcpy(data + sizeof(uint32_t), &seq, sizeof(uint64_t));
+    for (uint32_t i = MIN_EVENT_DATA_LEN; i < len; i++) {
+      data[i] = payload_byte(seq, i);
+    }
+    while (!event_queue_put(args->eq, args->producer, data, len)) {
+      args->full_retries++;
+      sched_yield();
+    }
+  }
+  free(data);
+  return NULL;
+}
+
+// Count a gap in a producer's sequence as missing events
+static void report_missing(consumer_args_t *const args,
+                           const uint32_t producer, const uint64_t from,
+                           const uint64_t to) {
+  fprintf(stderr, "missing events: producer %u seq %llu to %llu\n", producer,
+          (unsigned long long)from, (unsigned long long)(to - 1));
+  args->missing += to - from;
+}
+
+static void *consumer(void *arg) {
+  consumer_args_t *const args = (consumer_args_t *)arg;
+  pin(args->cpu);
+  uint64_t *const next_seq = args->next_seq;
+  // Runs until the producers have joined and the queue is drained, so a lost
+  // event fails the run instead of hanging it
+  for (;;) {
+    const bool done = atomic_load(&args->producers_done);
+    event_t *const evt = event_queue_get(args->eq);
+    if (evt == NULL) {
+      if (done) {
+        break;
+      }
+      sched_yield();
+      continue;
+    }
+    const uint8_t *const data = (const uint8_t *)evt->event_data;
+    uint32_t producer;
+    uint64_t seq;
+    memcpy(&producer, data, sizeof(uint32_t));
+    memcpy(&seq, data + sizeof(uint32_t), sizeof(uint64_t));
+    bool valid = producer == evt->event_id &&
+                 producer < args->producer_count &&
+                 seq >= next_seq[producer] && seq < args->event_count &&
+                 evt->event_data_length ==
+                     payload_length(producer, seq, args->max_size);
+    for (uint32_t i = MIN_EVENT_DATA_LEN; valid && i < evt->event_data_length;
+         i++) {
+      valid = data[i] == payload_byte(seq, i);
+    }
+    if (!valid) {
+      if (args->errors++ < 10) {
+        fprintf(stderr, "bad event: producer %u seq %llu length %u\n",
+                evt->event_id, (unsigned long long)seq,
+                evt->event_data_length);
+      }
+    } else {
+      // Resume after a gap, so only the lost events are reported
+      if (seq != next_seq[producer]) {
+        report_missing(args, producer, next_seq[producer], seq);
+      }
+      next_seq[producer] = seq + 1;
+    }
+    event_queue_pop(args->eq);
+  }
+
+  for (uint32_t p = 0; p < args->producer_count; p++) {
+    if (next_seq[p] != args->event_count) {
+      report_missing(args, p, next_seq[p], args->event_count);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Read the baseline throughput of a configuration
+ *
+ * @return Events per second, 0 if there is no baseline
+ */
+static double read_baseline(const char *const path, const char *const key) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    return 0;
+  }
+  char line_key[128];
+  double value;
+  double baseline = 0;
+  while (fscanf(file, "%127s %lf", line_key, &value) == 2) {
+    if (strcmp(line_key, key) == 0) {
+      baseline = value;
+    }
+  }
+  fclose(file);
+  return baseline;
+}
+
+static bool write_baseline(const char *const path, const char *const key,
+                           const double value) {
+  FILE *file = fopen(path, "a");
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  fprintf(file, "%s %.0f\n", key, value);
+  fclose(file);
+  return true;
+}
+
+static int parse_cpus(const char *list, int *const cpus, const int max) {
+  int count = 0;
+  while (*list != '\0' && count < max) {
+    char *end;
+    cpus[count++] = (int)strtol(list, &end, 10);
+    if (end == list) {
+      return -1;
+    }
+    list = (*end == ',') ? end + 1 : end;
+  }
+  return count;
+}
+
+static void usage(const char *const name) {
+  fprintf(stderr,
+          "usage: %s [--producers n] [--events n] [--buffer-size bytes] "
+          "[--alignment bytes] [--max-size bytes] [--cpus c0,c1,...] "
+          "[--baseline file] [--tolerance percent] [--update-baseline]\n",
+          name);
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t producer_count = 1;
+  uint64_t event_count = 1000000;
+  uint32_t buffer_size = 64 * 1024;
+  uint32_t alignment = 8;
+  uint32_t max_size = 256;
+  int cpus[MAX_PRODUCERS + 1];
+  int cpu_count = 0;
+  const char *baseline_path = NULL;
+  double tolerance = 20.0;
+  bool update_baseline = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--producers") == 0 && i + 1 < argc) {
+      producer_count = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+      event_count = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--buffer-size") == 0 && i + 1 < argc) {
+      buffer_size = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--alignment") == 0 && i + 1 < argc) {
+      alignment = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+      max_size = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+      cpu_count = parse_cpus(argv[++i], cpus, MAX_PRODUCERS + 1);
+    } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baseline_path = argv[++i];
+    } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      tolerance = strtod(argv[++i], NULL);
+    } else if (strcmp(argv[i], "--update-baseline") == 0) {
+      update_baseline = true;
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (producer_count == 0 || producer_count > MAX_PRODUCERS ||
+      max_size < MIN_EVENT_DATA_LEN || cpu_count < 0 ||
+      (update_baseline && baseline_path == NULL)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  uint8_t *buffer = malloc(buffer_size);
+  event_queue_t eq;
+  const bool locked = producer_count > 1;
+  event_queue_config_t eq_config = {.buffer = buffer,
+                                    .buffer_len = buffer_size,
+                                    .alignment = alignment,
+                                    .use_atomics = true,
+                                    .lock = locked ? producer_lock : NULL,
+                                    .unlock = locked ? producer_unlock : NULL};
+  if (buffer == NULL || !event_queue_init(&eq, &eq_config) ||
+      max_size + sizeof(EVENT_MARKER) + sizeof(event_t) + alignment >
+          buffer_size) {
+    fprintf(stderr, "invalid queue configuration\n");
+    return 1;
+  }
+
+  // Threads take cpus in order, producers first, then the consumer
+  producer_args_t producers[MAX_PRODUCERS];
+  pthread_t producer_threads[MAX_PRODUCERS];
+  consumer_args_t consumer_args = {
+      .eq = &eq,
+      .producer_count = producer_count,
+      .event_count = event_count,
+      .max_size = max_size,
+      .cpu = (cpu_count > 0) ? cpus[producer_count % cpu_count] : -1,
+      .producers_done = 0,
+      .errors = 0,
+      .missing = 0};
+  pthread_t consumer_thread;
+
+  const uint64_t start = event_clock_monotonic_ns();
+  pthread_create(&consumer_thread, NULL, consumer, &consumer_args);
+  for (uint32_t i = 0; i < producer_count; i++) {
+    producers[i] = (producer_args_t){
+        .eq = &eq,
+        .producer = i,
+        .event_count = event_count,
+        .max_size = max_size,
+        .cpu = (cpu_count > 0) ? cpus[i % cpu_count] : -1,
+        .full_retries = 0};
+    pthread_create(&producer_threads[i], NULL, producer, &producers[i]);
+  }
+  uint64_t full_retries = 0;
+  for (uint32_t i = 0; i < producer_count; i++) {
+    pthread_join(producer_threads[i], NULL);
+    full_retries += producers[i].full_retries;
+  }
+  atomic_store(&consumer_args.producers_done, 1);
+  pthread_join(consumer_thread, NULL);
+  const uint64_t elapsed = event_clock_monotonic_ns() - start;
+
+  const uint64_t total = event_count * producer_count;
+  const double rate = (double)total / ((double)elapsed / 1e9);
+  printf("mode          %s, %u producer%s\n", locked ? "locked" : "spsc",
+         producer_count, producer_count == 1 ? "" : "s");
+  printf("events        %llu\n", (unsigned long long)total);
+  printf("throughput    %.0f events/s\n", rate);
+  printf("full retries  %llu\n", (unsigned long long)full_retries);
+  printf("errors        %llu\n", (unsigned long long)consumer_args.errors);
+  printf("missing       %llu\n", (unsigned long long)consumer_args.missing);
+  free(buffer);
+  if (consumer_args.errors > 0 || consumer_args.missing > 0) {
+    return 1;
+  }
+
+  if (baseline_path != NULL) {
+    char key[128];
+    snprintf(key, sizeof(key), "p%u-s%u-b%u-a%u", producer_count, max_size,
+             buffer_size, alignment);
+    if (update_baseline) {
+      return write_baseline(baseline_path, key, rate) ? 0 : 1;
+    }
+    const double baseline = read_baseline(baseline_path, key);
+    if (baseline > 0) {
+      printf("baseline      %.0f events/s (%+.1f%%)\n", baseline,
+             (rate - baseline) / baseline * 100.0);
+      if (rate < baseline * (1.0 - tolerance / 100.0)) {
+        fprintf(stderr, "throughput regressed more than %.0f%%\n", tolerance);
+        return 1;
+      }
+    } else {
+      printf("baseline      none for %s\n", key);
+    }
+  }
+  return 0;
+}
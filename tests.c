@@ -19,12 +19,28 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include "block_pool.h"
+#include "event_compress.h"
 #include "event_queue.h"
+#include "event_queue_alloc.h"
+#include "event_stage.h"
+#include "merge_reader.h"
+#include "payload_pool.h"
+#include "rpc_channel.h"
+#include "segmented_queue.h"
+#include "slot_queue.h"
+#include "work_queue.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <sched.h>
+#define TEST_THREADS
+#endif
+
 #define BUFFER_SIZE (uint32_t)512
 
 static event_queue_config_t default_config(void *buffer, uint32_t buffer_size) {
@@ -37,6 +53,14 @@ static event_queue_config_t default_config(void *buffer, uint32_t buffer_size) {
   return eq_config;
 }
 
+#if defined(TEST_THREADS)
+static void sleep_ns(const uint64_t ns) {
+  struct timespec ts = {(time_t)(ns / 1000000000ULL),
+                        (long)(ns % 1000000000ULL)};
+  nanosleep(&ts, NULL);
+}
+#endif
+
 static void round_trip_test(event_queue_t *eq) {
   uint32_t event_id = 1;
   char *event_data = "Hello World";
@@ -250,6 +274,31 @@ void test_lock_unlock() {
   assert(test_unlock_count == 1);
 }
 
+/**
+ * Test write lock is released when the queue is full
+ */
+void test_lock_unlock_full() {
+  uint8_t buffer[BUFFER_SIZE];
+  event_queue_t eq;
+  event_queue_config_t eq_config = default_config(buffer, BUFFER_SIZE);
+  eq_config.lock = test_lock;
+  eq_config.unlock = test_unlock;
+  event_queue_init(&eq, &eq_config);
+
+  test_lock_count = 0;
+  test_unlock_count = 0;
+
+  uint8_t data[BUFFER_SIZE] = {0};
+  uint32_t put_count = 0;
+  while (event_queue_put(&eq, put_count, data, 100)) {
+    put_count++;
+  }
+  assert(event_queue_put(&eq, put_count, data, BUFFER_SIZE) == false);
+
+  assert(test_lock_count == put_count + 2);
+  assert(test_unlock_count == test_lock_count);
+}
+
 /**
  * Test circular buffer clear functionality
  */
@@ -431,6 +480,1510 @@ void test_circular_buffer_produce_bytes() {
     }    
 }
 
+/**
+ * Test latency histogram bucketing and percentiles
+ */
+void test_latency_histogram() {
+  latency_histogram_t h;
+  latency_histogram_reset(&h);
+  assert(latency_histogram_percentile(&h, 50.0) == 0);
+
+  // Values below the sub bucket count are exact
+  for (uint64_t v = 0; v < LATENCY_HISTOGRAM_SUB_BUCKETS; v++) {
+    assert(latency_histogram_bucket(v) == v);
+    assert(latency_histogram_bucket_max((uint32_t)v) == v);
+  }
+
+  // Every value lands in a bucket whose range contains it
+  for (uint32_t i = 0; i < 10000; i++) {
+    const uint64_t v = ((uint64_t)rand() << 20) ^ (uint64_t)rand();
+    const uint32_t bucket = latency_histogram_bucket(v);
+    assert(bucket < LATENCY_HISTOGRAM_BUCKETS);
+    assert(latency_histogram_bucket_max(bucket) >= v);
+    assert(bucket == 0 || latency_histogram_bucket_max(bucket - 1) < v);
+  }
+  assert(latency_histogram_bucket(UINT64_MAX) == LATENCY_HISTOGRAM_BUCKETS - 1);
+
+  for (uint64_t v = 1; v <= 1000; v++) {
+    latency_histogram_record(&h, v);
+  }
+  assert(h.total_count == 1000);
+  assert(h.min == 1);
+  assert(h.max == 1000);
+  assert(latency_histogram_mean(&h) == 500);
+  const uint64_t p50 = latency_histogram_percentile(&h, 50.0);
+  assert(p50 >= 500 && p50 <= 500 + 500 / LATENCY_HISTOGRAM_SUB_BUCKETS);
+  assert(latency_histogram_percentile(&h, 100.0) == 1000);
+}
+
+/**
+ * Test put to pop latency tracking
+ */
+void test_event_queue_latency() {
+  uint8_t buffer[BUFFER_SIZE];
+  latency_histogram_t histogram;
+  latency_histogram_t snapshot;
+  event_queue_t eq;
+  event_queue_config_t eq_config = default_config(buffer, BUFFER_SIZE);
+
+  // Not configured
+  event_queue_init(&eq, &eq_config);
+  assert(event_queue_latency_snapshot(&eq, &snapshot, false) == false);
+
+  const event_clock_source_t clocks[] = {EVENT_CLOCK_MONOTONIC,
+                                         EVENT_CLOCK_CYCLES};
+  for (uint32_t c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++) {
+    eq_config.latency_histogram = &histogram;
+    eq_config.clock = clocks[c];
+    event_queue_init(&eq, &eq_config);
+
+    round_trip_test(&eq);
+    round_trip_test(&eq);
+
+    assert(event_queue_latency_snapshot(&eq, &snapshot, true) == true);
+    assert(snapshot.total_count == 2);
+    assert(snapshot.min <= snapshot.max);
+
+    // Reset after snapshot
+    assert(event_queue_latency_snapshot(&eq, &snapshot, false) == true);
+    assert(snapshot.total_count == 0);
+  }
+
+  // Timestamped events still wrap and fill correctly
+  eq_config.clock = EVENT_CLOCK_MONOTONIC;
+  event_queue_init(&eq, &eq_config);
+  uint8_t data[64] = {0};
+  uint32_t put_count = 0;
+  uint32_t get_count = 0;
+  for (uint32_t i = 0; i < 100; i++) {
+    while (event_queue_put(&eq, put_count, data, rand() % 64)) {
+      put_count++;
+    }
+    event_t *out_event;
+    while ((out_event = event_queue_get(&eq)) != NULL) {
+      assert(out_event->event_id == get_count);
+      get_count++;
+      event_queue_pop(&eq);
+    }
+  }
+  assert(event_queue_latency_snapshot(&eq, &snapshot, false) == true);
+  assert(snapshot.total_count == get_count);
+}
+
+/**
+ * Test mapping events to iovecs and releasing them
+ */
+void test_event_queue_iov() {
+  uint8_t buffer[BUFFER_SIZE];
+  event_queue_t eq;
+  event_queue_config_t eq_config = default_config(buffer, BUFFER_SIZE);
+  event_queue_init(&eq, &eq_config);
+  struct iovec iov[8];
+
+  assert(event_queue_get_iov(&eq, iov, 8, false) == 0);
+
+  char *event_data[] = {"alpha", "bravo!", "charlie"};
+  for (uint32_t i = 0; i < 3; i++) {
+    assert(event_queue_put(&eq, i, event_data[i], strlen(event_data[i])));
+  }
+
+  // Data only, one iovec per event
+  assert(event_queue_get_iov(&eq, iov, 8, false) == 3);
+  for (uint32_t i = 0; i < 3; i++) {
+    assert(iov[i].iov_len == strlen(event_data[i]));
+    assert(memcmp(iov[i].iov_base, event_data[i], iov[i].iov_len) == 0);
+  }
+  assert(event_queue_get_iov(&eq, iov, 2, false) == 2);
+
+  // Partial transfer keeps the partially sent event
+  assert(event_queue_release_iov(&eq, 5 + 3, false) == 5);
+  event_t *out_event = event_queue_get(&eq);
+  assert(out_event != NULL && out_event->event_id == 1);
+
+  // With headers, contiguous records share one iovec
+  assert(event_queue_get_iov(&eq, iov, 8, true) == 1);
+  assert(iov[0].iov_len == (size_t)eq._cb.fill_count);
+  assert(event_queue_release_iov(&eq, iov[0].iov_len, true) == iov[0].iov_len);
+  assert(event_queue_get(&eq) == NULL);
+
+  // Wrapped records split into two iovecs
+  event_queue_init(&eq, &eq_config);
+  uint8_t data[100] = {0};
+  uint32_t put_count = 0;
+  while (event_queue_put(&eq, put_count, data, sizeof(data))) {
+    put_count++;
+  }
+  event_queue_pop(&eq);
+  event_queue_pop(&eq);
+  assert(event_queue_put(&eq, put_count, data, sizeof(data)));
+  put_count++;
+  assert(event_queue_get_iov(&eq, iov, 8, true) == 2);
+  assert(event_queue_get_iov(&eq, iov, 1, true) == 1);
+  assert(event_queue_get_iov(&eq, iov, 8, false) == put_count - 2);
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < put_count - 2; i++) {
+    assert(iov[i].iov_len == sizeof(data));
+    total += iov[i].iov_len;
+  }
+  assert(event_queue_release_iov(&eq, total, false) == total);
+  assert(event_queue_get(&eq) == NULL);
+
+  // Release stops at the mapped events, an empty event after them stays
+  event_queue_init(&eq, &eq_config);
+  assert(event_queue_put(&eq, 1, data, 4));
+  assert(event_queue_put(&eq, 2, data, 0));
+  assert(event_queue_get_iov(&eq, iov, 1, false) == 1);
+  assert(event_queue_release_iov(&eq, 4, false) == 4);
+  out_event = event_queue_get(&eq);
+  assert(out_event != NULL && out_event->event_id == 2);
+  event_queue_pop(&eq);
+  assert(event_queue_get(&eq) == NULL);
+
+  // Filtered events are neither mapped nor counted on release
+  uint64_t bitmap[1];
+  event_filter_t filter;
+  event_filter_init(&filter, bitmap, 1, NULL, 0);
+  event_filter_add(&filter, 5);
+  event_queue_init(&eq, &eq_config);
+  event_queue_set_filter(&eq, &filter);
+  for (uint32_t i = 0; i < 6; i++) {
+    assert(event_queue_put(&eq, (i % 2) ? 5 : 6, data, 4));
+  }
+  assert(event_queue_get_iov(&eq, iov, 8, false) == 3);
+  assert(event_queue_get_iov(&eq, iov, 8, true) == 3);
+  assert(event_queue_release_iov(&eq, 8, false) == 8);
+  out_event = event_queue_get(&eq);
+  assert(out_event != NULL && out_event->event_id == 5);
+  event_queue_pop(&eq);
+  assert(event_queue_get(&eq) == NULL);
+  assert(eq.stats.filtered == 3);
+  event_queue_set_filter(&eq, NULL);
+
+  // Mapping ends before an expired event, mapped events release even if they
+  // have expired since
+  const uint64_t now = event_clock_now(eq_config.clock);
+  eq_config.drop_expired = true;
+  event_queue_init(&eq, &eq_config);
+  assert(event_queue_put_expiry(&eq, 1, data, 4, now - 1));
+  assert(event_queue_put_expiry(&eq, 2, data, 4, now + 2000000));
+  assert(event_queue_put_expiry(&eq, 3, data, 4, now - 1));
+  assert(event_queue_put(&eq, 4, data, 4));
+  assert(event_queue_get_iov(&eq, iov, 8, false) == 1);
+  assert(eq.stats.expired == 1);
+  while (event_clock_now(eq_config.clock) <= now + 2000000) {
+  }
+  assert(event_queue_release_iov(&eq, 4, false) == 4);
+  assert(event_queue_get_iov(&eq, iov, 8, false) == 1);
+  assert(eq.stats.expired == 2);
+  assert(event_queue_release_iov(&eq, 4, false) == 4);
+  assert(event_queue_get(&eq) == NULL);
+}
+
+/**
+ * Test capturing put traffic and reading it back
+ */
+void test_event_capture() {
+  uint8_t buffer[BUFFER_SIZE];
+  uint8_t event_data[BUFFER_SIZE];
+  event_queue_t eq;
+  event_capture_t cap;
+  FILE *file = tmpfile();
+  assert(file != NULL);
+  assert(event_capture_open(&cap, file));
+
+  event_queue_config_t eq_config = default_config(buffer, BUFFER_SIZE);
+  eq_config.capture = &cap;
+  event_queue_init(&eq, &eq_config);
+
+  // Only placed events are captured
+  uint32_t put_count = 0;
+  for (uint32_t i = 0; i < 200; i++) {
+    const uint32_t event_data_len = (i * 37) % 200;
+    memset(event_data, (int)i, event_data_len);
+    if (event_queue_put(&eq, i * 1000, event_data, event_data_len)) {
+      put_count++;
+    }
+    event_queue_pop(&eq);
+  }
+  assert(event_queue_put(&eq, 1, event_data, BUFFER_SIZE) == false);
+  assert(cap.record_count == put_count);
+  assert(event_capture_close(&cap));
+
+  rewind(file);
+  event_capture_record_t record;
+  assert(event_capture_open_read(&cap, file));
+  uint32_t read_count = 0;
+  for (uint32_t i = 0; i < 200; i++) {
+    const uint32_t event_data_len = (i * 37) % 200;
+    assert(event_capture_read(&cap, &record, event_data, BUFFER_SIZE));
+    assert(record.event_id == i * 1000);
+    assert(record.event_data_length == event_data_len);
+    for (uint32_t j = 0; j < event_data_len; j++) {
+      assert(event_data[j] == (uint8_t)i);
+    }
+    read_count++;
+  }
+  assert(read_count == put_count);
+  assert(event_capture_read(&cap, &record, event_data, BUFFER_SIZE) == false);
+  assert(cap.error == false);
+
+  // Event data larger than the read buffer
+  rewind(file);
+  assert(event_capture_open_read(&cap, file));
+  while (event_capture_read(&cap, &record, event_data, 0)) {
+  }
+  assert(cap.error == true);
+  assert(cap.record_count == 1);
+  fclose(file);
+}
+
+/**
+ * Test block pool allocation and free
+ */
+void test_block_pool() {
+  uint64_t buffer[BUFFER_SIZE / sizeof(uint64_t)];
+  block_pool_t pool;
+  void *blocks[BUFFER_SIZE];
+
+  assert(block_pool_init(&pool, NULL, BUFFER_SIZE, 8) == false);
+  assert(block_pool_init(&pool, buffer, 4, 8) == false);
+
+  // Block size rounded up to the pool alignment
+  assert(block_pool_init(&pool, buffer, BUFFER_SIZE, 30) == true);
+  assert(pool.block_size == 32);
+  assert(pool.block_count == BUFFER_SIZE / 32);
+
+  for (uint32_t i = 0; i < pool.block_count; i++) {
+    blocks[i] = block_pool_alloc(&pool);
+    assert(blocks[i] != NULL);
+    assert(block_pool_block(&pool, block_pool_index(&pool, blocks[i])) ==
+           blocks[i]);
+    memset(blocks[i], 0xAA, pool.block_size);
+  }
+  assert(pool.free_count == 0);
+  assert(block_pool_alloc(&pool) == NULL);
+
+  block_pool_free(&pool, blocks[3]);
+  assert(block_pool_alloc(&pool) == blocks[3]);
+  for (uint32_t i = 0; i < pool.block_count; i++) {
+    block_pool_free(&pool, blocks[i]);
+  }
+  assert(pool.free_count == pool.block_count);
+}
+
+/**
+ * Test segmented queue growth from and return to a shared pool
+ */
+void test_segmented_queue() {
+  static uint64_t pool_buffer[4 * BUFFER_SIZE / sizeof(uint64_t)];
+  uint8_t event_data[BUFFER_SIZE];
+  block_pool_t pool;
+  segmented_queue_t sq, other;
+  assert(block_pool_init(&pool, pool_buffer, sizeof(pool_buffer),
+                         BUFFER_SIZE / 2));
+
+  segmented_queue_config_t sq_config = {.pool = &pool,
+                                        .alignment = 4,
+                                        .use_atomics = false,
+                                        .max_segments = 0,
+                                        .lock = NULL,
+                                        .unlock = NULL};
+  assert(segmented_queue_init(&sq, &sq_config));
+  assert(segmented_queue_init(&other, &sq_config));
+  assert(pool.free_count == pool.block_count - 2);
+  assert(segmented_queue_get(&sq) == NULL);
+
+  // Event larger than a segment
+  assert(segmented_queue_put(&sq, 0, event_data, BUFFER_SIZE) == false);
+  assert(pool.free_count == pool.block_count - 2);
+
+  // Grow until the shared pool runs out
+  uint32_t put_count = 0;
+  while (segmented_queue_put(&sq, put_count, event_data, put_count % 40)) {
+    put_count++;
+  }
+  assert(pool.free_count == 0);
+  assert(atomic_load(&sq.segment_count) == (int)pool.block_count - 1);
+  assert(put_count > (BUFFER_SIZE / 2) / (40 + sizeof(event_t)));
+
+  // The other queue still works within its own segment
+  assert(segmented_queue_put(&other, 7, event_data, 4));
+  assert(segmented_queue_get(&other)->event_id == 7);
+  segmented_queue_pop(&other);
+
+  // Drain, returning segments to the pool
+  for (uint32_t i = 0; i < put_count; i++) {
+    event_t *out_event = segmented_queue_get(&sq);
+    assert(out_event != NULL);
+    assert(out_event->event_id == i);
+    assert(out_event->event_data_length == i % 40);
+    segmented_queue_pop(&sq);
+  }
+  assert(segmented_queue_get(&sq) == NULL);
+  assert(atomic_load(&sq.segment_count) == 1);
+  assert(pool.free_count == pool.block_count - 2);
+
+  // Bounded growth
+  segmented_queue_deinit(&sq);
+  sq_config.max_segments = 2;
+  assert(segmented_queue_init(&sq, &sq_config));
+  while (segmented_queue_put(&sq, 0, event_data, 40)) {
+  }
+  assert(atomic_load(&sq.segment_count) == 2);
+
+  segmented_queue_deinit(&sq);
+  segmented_queue_deinit(&other);
+  assert(pool.free_count == pool.block_count);
+}
+
+#if defined(TEST_THREADS)
+typedef struct {
+  event_queue_t *eq;
+  uint8_t *data;
+  volatile atomic_int_t placed;
+} blocked_put_t;
+
+static void *blocked_put(void *arg) {
+  blocked_put_t *const put = (blocked_put_t *)arg;
+  atomic_store(&put->placed, event_queue_put_timeout(put->eq, 1, put->data,
+                                                     100, EVENT_WAIT_FOREVER));
+  return NULL;
+}
+#endif
+
+/**
+ * Test blocking put timeouts and parked producer wake up
+ */
+void test_event_queue_put_timeout() {
+  uint8_t buffer[BUFFER_SIZE];
+  uint8_t data[BUFFER_SIZE] = {0};
+  event_queue_t eq;
+  event_queue_config_t eq_config = default_config(buffer, BUFFER_SIZE);
+  const event_wait_strategy_t strategies[] = {
+      {.spin_count = 100, .yield_count = 0, .park = false},
+      {.spin_count = 10, .yield_count = 10, .park = false},
+      {.spin_count = 10, .yield_count = 10, .park = true},
+      {.spin_count = 0, .yield_count = 0, .park = true}};
+
+  for (uint32_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); i++) {
+    eq_config.put_wait = strategies[i];
+    event_queue_init(&eq, &eq_config);
+
+    // Space available, no wait
+    assert(event_queue_put_timeout(&eq, 0, data, 100, 0));
+    event_queue_pop(&eq);
+
+    // Never fits
+    assert(event_queue_put_timeout(&eq, 0, data, BUFFER_SIZE,
+                                   EVENT_WAIT_FOREVER) == false);
+
+    // Fill with records a third of the size of the blocked one
+    while (event_queue_put(&eq, 0, data, 20)) {
+    }
+
+    // A timed out producer withdraws the space it asked for
+    const uint64_t timeout_ns = 2000000;
+    const uint64_t start = event_clock_monotonic_ns();
+    int seq = atomic_load(&eq._space_seq);
+    assert(event_queue_put_timeout(&eq, 1, data, 100, timeout_ns) == false);
+    assert(event_clock_monotonic_ns() - start >= timeout_ns);
+    assert(atomic_load(&eq._space_needed) == 0);
+    assert(atomic_load(&eq._space_seq) == seq + (strategies[i].park ? 1 : 0));
+
+#if defined(TEST_THREADS)
+    // A producer blocked on the full queue places its event once the
+    // consumer frees enough space
+    blocked_put_t put = {.eq = &eq, .data = data, .placed = 0};
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, blocked_put, &put) == 0);
+    if (strategies[i].park) {
+      // Wait for the parked producer to publish the space it needs
+      while (atomic_load(&eq._space_needed) != 120) {
+        sleep_ns(100000);
+      }
+      seq = atomic_load(&eq._space_seq);
+
+      // Freeing too little leaves it parked
+      event_queue_pop(&eq);
+      event_queue_pop(&eq);
+      sleep_ns(1000000);
+      assert(atomic_load(&eq._space_needed) == 120);
+      assert(atomic_load(&eq._space_seq) == seq);
+      assert(atomic_load(&put.placed) == 0);
+      event_queue_pop(&eq);
+      assert(atomic_load(&eq._space_seq) != seq);
+    } else {
+      sleep_ns(1000000);
+      event_queue_pop(&eq);
+      event_queue_pop(&eq);
+      event_queue_pop(&eq);
+    }
+    assert(pthread_join(thread, NULL) == 0);
+    assert(atomic_load(&put.placed) == 1);
+    assert(atomic_load(&eq._space_needed) == 0);
+#endif
+  }
+}
+
+/**
+ * Test event queue memory allocation
+ */
+void test_event_queue_alloc() {
+  event_queue_memory_t mem;
+  event_queue_t eq;
+  event_queue_alloc_config_t alloc_config = {.length = 1024 * 1024 + 1,
+                                             .numa_node = EVENT_QUEUE_NUMA_ANY,
+                                             .huge_pages = false,
+                                             .prefault_threads = 0};
+
+  assert(event_queue_alloc(&mem, &(event_queue_alloc_config_t){0}) == false);
+
+  for (uint32_t i = 0; i < 3; i++) {
+    alloc_config.huge_pages = (i > 0);
+    alloc_config.prefault_threads = i * 2;
+    assert(event_queue_alloc(&mem, &alloc_config));
+    assert(mem.mapped_length >= alloc_config.length);
+
+    // Memory arrives zeroed, the queue need not clear it
+    for (uint32_t j = 0; j < alloc_config.length; j += 4096) {
+      assert(((uint8_t *)mem.buffer)[j] == 0);
+    }
+    event_queue_config_t eq_config =
+        default_config(mem.buffer, alloc_config.length);
+    eq_config.skip_clear = true;
+    assert(event_queue_init(&eq, &eq_config));
+    round_trip_test(&eq);
+    event_queue_free(&mem);
+    assert(mem.buffer == NULL);
+  }
+
+  // Node out of range
+  alloc_config.numa_node = 1 << 20;
+  assert(event_queue_alloc(&mem, &alloc_config) == false);
+}
+
+/**
+ * Test size dispatched payload copies
+ */
+void test_event_copy() {
+  static uint8_t src[4 * BUFFER_SIZE];
+  static uint8_t dst[4 * BUFFER_SIZE + 64];
+  for (uint32_t i = 0; i < sizeof(src); i++) {
+    src[i] = (uint8_t)rand();
+  }
+
+  // Every small length, guard bytes untouched
+  for (uint32_t len = 0; len <= EVENT_COPY_SMALL_MAX; len++) {
+    memset(dst, 0xEE, EVENT_COPY_SMALL_MAX + 1);
+    event_copy_small(dst, src + len, len);
+    assert(memcmp(dst, src + len, len) == 0);
+    assert(dst[len] == 0xEE);
+  }
+
+  // Streaming stores with unaligned destinations and odd lengths
+  for (uint32_t offset = 0; offset < 64; offset += 7) {
+    const uint32_t lengths[] = {1, 255, 256, 1000, sizeof(src)};
+    for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+      memset(dst, 0xEE, sizeof(dst));
+      event_copy_stream(dst + offset, src, lengths[i]);
+      assert(memcmp(dst + offset, src, lengths[i]) == 0);
+      assert(offset == 0 || dst[offset - 1] == 0xEE);
+      assert(offset + lengths[i] == sizeof(dst) ||
+             dst[offset + lengths[i]] == 0xEE);
+    }
+  }
+
+  // Event queue round trip across all strategies
+  static uint8_t buffer[8 * BUFFER_SIZE];
+  event_queue_t eq;
+  event_queue_config_t eq_config = default_config(buffer, sizeof(buffer));
+  eq_config.copy_stream_threshold = 512;
+  event_queue_init(&eq, &eq_config);
+  for (uint32_t len = 0; len < sizeof(src); len += 97) {
+    assert(event_queue_put(&eq, len, src, len));
+    event_t *out_event = event_queue_get(&eq);
+    assert(out_event != NULL);
+    assert(out_event->event_data_length == len);
+    assert(memcmp(out_event->event_data, src, len) == 0);
+    event_queue_pop(&eq);
+  }
+}
+
+/**
+ * Test fixed size slot queue
+ */
+void test_slot_queue() {
+  typedef struct {
+    uint32_t sequence;
+    uint8_t payload[9];
+  } slot_event_t;
+  uint8_t buffer[BUFFER_SIZE];
+  slot_queue_t sq;
+  slot_queue_config_t sq_config = {.buffer = buffer,
+                                   .buffer_len = BUFFER_SIZE,
+                                   .slot_size = sizeof(slot_event_t),
+                                   .alignment = 8,
+                                   .use_atomics = true,
+                                   .lock = test_lock,
+                                   .unlock = test_unlock};
+
+  assert(slot_queue_init(&sq, &(slot_queue_config_t){.buffer = buffer,
+                                                      .buffer_len = 4,
+                                                      .slot_size = 8}) ==
+         false);
+  assert(slot_queue_init(&sq, &sq_config));
+  assert(sq.slot_stride == 16);
+  assert(sq._cb.length == BUFFER_SIZE / 16);
+  assert(slot_queue_get(&sq) == NULL);
+  slot_queue_pop(&sq);
+
+  test_lock_count = 0;
+  test_unlock_count = 0;
+
+  uint32_t put_count = 0;
+  uint32_t get_count = 0;
+  for (uint32_t cycle = 0; cycle < 10; cycle++) {
+    slot_event_t event = {0};
+    for (;;) {
+      event.sequence = put_count;
+      memset(event.payload, (int)put_count, sizeof(event.payload));
+      if (!slot_queue_put(&sq, &event)) {
+        break;
+      }
+      put_count++;
+    }
+    assert(put_count - get_count == BUFFER_SIZE / 16);
+
+    // Drain a varying amount so head and tail wrap at different points
+    const uint32_t drain = (cycle % 3 == 2) ? BUFFER_SIZE / 16 : 7 + cycle;
+    for (uint32_t i = 0; i < drain; i++) {
+      slot_event_t *const out = (slot_event_t *)slot_queue_get(&sq);
+      assert(out != NULL);
+      assert(out->sequence == get_count);
+      assert(out->payload[8] == (uint8_t)get_count);
+      slot_queue_pop(&sq);
+      get_count++;
+    }
+  }
+  assert(test_unlock_count == test_lock_count);
+  assert(test_lock_count == put_count + 10);
+
+  slot_queue_clear(&sq);
+  assert(slot_queue_get(&sq) == NULL);
+}
+
+/**
+ * Test event id filter
+ */
+void test_event_filter() {
+  uint64_t bitmap[2];
+  uint32_t ids[4];
+  event_filter_t filter;
+  event_filter_init(&filter, bitmap, 2, ids, 4);
+
+  assert(event_filter_add(&filter, 3));
+  assert(event_filter_add(&filter, 127));
+  assert(event_filter_add(&filter, 1000000));
+  assert(event_filter_add(&filter, 500));
+  assert(event_filter_add(&filter, 500));
+  assert(event_filter_add(&filter, 128));
+  assert(event_filter_add(&filter, 9999));
+  assert(event_filter_add(&filter, 10000) == false);
+  assert(filter.id_count == 4);
+  assert(filter.ids[0] == 128 && filter.ids[3] == 1000000);
+
+  for (uint32_t id = 0; id < 2000; id++) {
+    const bool expected = id == 3 || id == 127 || id == 128 || id == 500;
+    assert(event_filter_match(&filter, id) == expected);
+  }
+  assert(event_filter_match(&filter, 9999));
+  assert(event_filter_match(&filter, UINT32_MAX) == false);
+
+  event_filter_remove(&filter, 3);
+  event_filter_remove(&filter, 500);
+  event_filter_remove(&filter, 501);
+  assert(event_filter_match(&filter, 3) == false);
+  assert(event_filter_match(&filter, 500) == false);
+  assert(filter.id_count == 3);
+
+  // Set only
+  event_filter_init(&filter, NULL, 0, ids, 4);
+  assert(event_filter_add(&filter, 0));
+  assert(event_filter_match(&filter, 0));
+  assert(event_filter_match(&filter, 1) == false);
+}
+
+/**
+ * Test consumer side filtering of a shared queue
+ */
+void test_event_queue_filter() {
+  uint8_t buffer[BUFFER_SIZE];
+  uint64_t bitmap[1];
+  event_filter_t filter;
+  event_queue_t eq;
+  event_queue_config_t eq_config = default_config(buffer, BUFFER_SIZE);
+  event_queue_init(&eq, &eq_config);
+  event_filter_init(&filter, bitmap, 1, NULL, 0);
+  event_filter_add(&filter, 5);
+  event_queue_set_filter(&eq, &filter);
+
+  // Only filtered out events
+  uint8_t data[16] = {0};
+  for (uint32_t i = 0; i < 4; i++) {
+    assert(event_queue_put(&eq, i, data, i * 3));
+  }
+  assert(event_queue_get(&eq) == NULL);
+  assert(eq.stats.filtered == 4);
+  assert(eq._cb.fill_count == 0);
+
+  // Matching events delivered in order, across wraps
+  uint32_t put_count = 0;
+  uint32_t matched = 0;
+  uint32_t get_count = 0;
+  for (uint32_t cycle = 0; cycle < 50; cycle++) {
+    for (;;) {
+      memcpy(data, &put_count, sizeof(put_count));
+      if (!event_queue_put(&eq, (put_count % 7 == 0) ? 5 : 6, data,
+                           sizeof(put_count) + cycle % 5)) {
+        break;
+      }
+      matched += (put_count % 7 == 0);
+      put_count++;
+    }
+    event_t *out_event;
+    while ((out_event = event_queue_get(&eq)) != NULL) {
+      assert(out_event->event_id == 5);
+      assert(*(uint32_t *)out_event->event_data % 7 == 0);
+      get_count++;
+      event_queue_pop(&eq);
+    }
+  }
+  assert(get_count == matched);
+  assert(eq.stats.filtered == 4 + put_count - matched);
+
+  // Detached
+  event_queue_set_filter(&eq, NULL);
+  assert(event_queue_put(&eq, 6, NULL, 0));
+  assert(event_queue_get(&eq)->event_id == 6);
+}
+
+/**
+ * Test per-event expiry and bulk drop of expired events
+ */
+void test_event_queue_expiry() {
+  uint8_t buffer[BUFFER_SIZE];
+  latency_histogram_t histogram;
+  event_queue_t eq;
+  event_queue_config_t eq_config = default_config(buffer, BUFFER_SIZE);
+  event_queue_init(&eq, &eq_config);
+
+  const uint64_t now = event_clock_now(eq_config.clock);
+  const uint64_t past = now - 1;
+  const uint64_t future = now + 3600ULL * 1000000000ULL;
+
+  // Expired events are delivered unless dropped
+  assert(event_queue_put_expiry(&eq, 1, "stale", 6, past));
+  event_t *out_event = event_queue_get(&eq);
+  assert(out_event != NULL && out_event->event_id == 1);
+  assert(memcmp(out_event->event_data, "stale", 6) == 0);
+
+  // Bulk drop stops at the first live event
+  assert(event_queue_put_expiry(&eq, 2, "stale", 6, past));
+  assert(event_queue_put_expiry(&eq, 3, "live", 5, future));
+  assert(event_queue_put_expiry(&eq, 4, "stale", 6, past));
+  assert(event_queue_drop_expired(&eq) == 2);
+  assert(eq.stats.expired == 2);
+  out_event = event_queue_get(&eq);
+  assert(out_event != NULL && out_event->event_id == 3);
+  assert(memcmp(out_event->event_data, "live", 5) == 0);
+  event_queue_pop(&eq);
+  assert(event_queue_drop_expired(&eq) == 1);
+  assert(event_queue_get(&eq) == NULL);
+
+  // Dropped on get, mixed with events without expiry and timestamps
+  eq_config.drop_expired = true;
+  eq_config.latency_histogram = &histogram;
+  event_queue_init(&eq, &eq_config);
+  uint8_t data[20] = {0};
+  uint32_t put_count = 0;
+  uint32_t live_count = 0;
+  uint32_t get_count = 0;
+  for (uint32_t cycle = 0; cycle < 20; cycle++) {
+    for (;;) {
+      bool placed;
+      if (put_count % 3 == 0) {
+        placed = event_queue_put(&eq, put_count, data, cycle);
+      } else {
+        placed = event_queue_put_expiry(&eq, put_count, data, cycle,
+                                        (put_count % 3 == 1) ? past : future);
+      }
+      if (!placed) {
+        break;
+      }
+      live_count += (put_count % 3 != 1);
+      put_count++;
+    }
+    while ((out_event = event_queue_get(&eq)) != NULL) {
+      assert(out_event->event_id % 3 != 1);
+      assert(out_event->event_data_length == cycle);
+      get_count++;
+      event_queue_pop(&eq);
+    }
+  }
+  assert(get_count == live_count);
+  assert(eq.stats.expired == put_count - live_count);
+  assert(histogram.total_count == live_count);
+}
+
+static void count_work(event_t *const evt, void *const context) {
+  uint32_t *const handled = (uint32_t *)context;
+  handled[evt->event_id]++;
+}
+
+#if defined(TEST_THREADS)
+#define WORK_EVENTS 20000
+
+typedef struct {
+  work_queue_t *wq;
+  uint32_t worker;
+  uint8_t *seen;
+  volatile atomic_int_t *remaining;
+} work_worker_t;
+
+static void mark_work(event_t *const evt, void *const context) {
+  ((uint8_t *)context)[evt->event_id]++;
+}
+
+static void *work_worker(void *arg) {
+  work_worker_t *const worker = (work_worker_t *)arg;
+  while (atomic_load(worker->remaining) > 0) {
+    const uint32_t count = work_queue_consume(worker->wq, worker->worker,
+                                              mark_work, worker->seen, 4);
+    if (count > 0) {
+      atomicFetchAdd(worker->remaining, -(int)count);
+    } else {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+#endif
+
+/**
+ * Test sharded work queues and work stealing between workers
+ */
+void test_work_queue() {
+  static uint64_t memory[4 * BUFFER_SIZE / sizeof(uint64_t)];
+  work_queue_shard_t shards[4];
+  work_queue_t wq;
+  work_queue_config_t config = {.buffer = memory,
+                                .buffer_len = sizeof(memory),
+                                .shards = shards,
+                                .shard_count = 4,
+                                .alignment = 8,
+                                .steal_batch = 3,
+                                .multi_producer = true};
+  uint32_t handled[16] = {0};
+  uint8_t data[16] = {0};
+
+  work_queue_config_t bad = config;
+  bad.shard_count = 0;
+  assert(!work_queue_init(&wq, &bad));
+  bad = config;
+  bad.buffer_len = 4;
+  assert(!work_queue_init(&wq, &bad));
+  assert(work_queue_init(&wq, &config));
+
+  // Nothing queued anywhere
+  assert(work_queue_consume(&wq, 0, count_work, handled, 8) == 0);
+
+  // Shard 1 gets 10 events, shard 2 gets 2
+  for (uint32_t i = 0; i < 10; i++) {
+    assert(work_queue_put(&wq, 1, i, data, sizeof(data)));
+  }
+  assert(work_queue_put(&wq, 2, 10, data, sizeof(data)));
+  assert(work_queue_put(&wq, 2, 11, data, sizeof(data)));
+
+  // Idle worker 0 steals a batch from the oldest end of the busiest shard
+  assert(work_queue_consume(&wq, 0, count_work, handled, 8) == 3);
+  assert(handled[0] == 1 && handled[1] == 1 && handled[2] == 1);
+  assert(handled[3] == 0);
+
+  // Owner consumes its own shard first, bounded by max
+  assert(work_queue_consume(&wq, 2, count_work, handled, 1) == 1);
+  assert(handled[10] == 1 && handled[11] == 0);
+
+  // A shard being consumed elsewhere is passed over for the next busiest
+  atomic_store(&shards[1].consume_lock, 1);
+  assert(work_queue_consume(&wq, 3, count_work, handled, 8) == 1);
+  assert(handled[11] == 1);
+  assert(work_queue_consume(&wq, 3, count_work, handled, 8) == 0);
+  atomic_store(&shards[1].consume_lock, 0);
+
+  assert(work_queue_consume(&wq, 1, count_work, handled, 16) == 7);
+  for (uint32_t i = 0; i < 12; i++) {
+    assert(handled[i] == 1);
+  }
+  assert(work_queue_consume(&wq, 3, count_work, handled, 8) == 0);
+
+  // Shards are sized from an even split of the buffer
+  uint32_t placed = 0;
+  while (work_queue_put(&wq, 0, 0, data, sizeof(data))) {
+    placed++;
+  }
+  assert(placed > 0);
+  assert(work_queue_put(&wq, 3, 0, data, sizeof(data)));
+
+#if defined(TEST_THREADS)
+  // Workers stealing from a shard one producer keeps busy handle every event
+  // exactly once
+  static uint8_t seen[WORK_EVENTS];
+  volatile atomic_int_t remaining;
+  work_worker_t workers[4];
+  pthread_t threads[4];
+  assert(work_queue_init(&wq, &config));
+  atomic_store(&remaining, WORK_EVENTS);
+  for (uint32_t i = 0; i < 4; i++) {
+    workers[i] = (work_worker_t){
+        .wq = &wq, .worker = i, .seen = seen, .remaining = &remaining};
+    assert(pthread_create(&threads[i], NULL, work_worker, &workers[i]) == 0);
+  }
+  for (uint32_t i = 0; i < WORK_EVENTS; i++) {
+    while (!work_queue_put(&wq, 0, i, data, sizeof(data))) {
+      sched_yield();
+    }
+  }
+  for (uint32_t i = 0; i < 4; i++) {
+    assert(pthread_join(threads[i], NULL) == 0);
+  }
+  for (uint32_t i = 0; i < WORK_EVENTS; i++) {
+    assert(seen[i] == 1);
+  }
+#endif
+}
+
+#if defined(TEST_THREADS)
+typedef struct {
+  rpc_channel_t *ch;
+  rpc_handle_t handle;
+  bool replied;
+  uint32_t reply;
+} rpc_caller_t;
+
+static void *rpc_caller_wait(void *arg) {
+  rpc_caller_t *const caller = (rpc_caller_t *)arg;
+  void *reply;
+  uint32_t reply_len;
+  caller->replied = rpc_channel_wait(caller->ch, caller->handle,
+                                     EVENT_WAIT_FOREVER, &reply, &reply_len);
+  if (caller->replied) {
+    memcpy(&caller->reply, reply, sizeof(caller->reply));
+  }
+  return NULL;
+}
+#endif
+
+/**
+ * Test request/response calls through completion slots
+ */
+void test_rpc_channel() {
+  uint8_t request_buffer[BUFFER_SIZE];
+  uint8_t reply_buffer[4 * 32];
+  rpc_channel_slot_t slots[4];
+  rpc_channel_t ch;
+  rpc_channel_config_t config = {.request_buffer = request_buffer,
+                                 .request_buffer_len = sizeof(request_buffer),
+                                 .alignment = 4,
+                                 .lock = NULL,
+                                 .unlock = NULL,
+                                 .slots = slots,
+                                 .slot_count = 4,
+                                 .reply_buffer = reply_buffer,
+                                 .reply_capacity = 32,
+                                 .wait = {.spin_count = 4, .yield_count = 4}};
+  rpc_handle_t handles[5];
+  uint32_t request = 0;
+  void *reply;
+  uint32_t reply_len;
+
+  rpc_channel_config_t bad = config;
+  bad.slot_count = 0;
+  assert(!rpc_channel_init(&ch, &bad));
+  assert(rpc_channel_init(&ch, &config));
+
+  // Every slot in use
+  for (uint32_t i = 0; i < 4; i++) {
+    request = i;
+    assert(rpc_channel_call(&ch, &request, sizeof(request), &handles[i]));
+  }
+  assert(!rpc_channel_call(&ch, &request, sizeof(request), &handles[4]));
+
+  // Serve requests in order, the reply lands in the caller's slot
+  event_t *evt;
+  uint32_t served = 0;
+  while ((evt = rpc_channel_get_request(&ch)) != NULL) {
+    assert(evt->event_id == handles[served]);
+    uint32_t value;
+    memcpy(&value, evt->event_data, sizeof(value));
+    assert(value == served);
+    value *= 10;
+    if (served == 3) {
+      // Build the reply in place
+      uint8_t *const buffer = rpc_channel_reply_buffer(&ch, evt->event_id);
+      assert(buffer != NULL);
+      memcpy(buffer, &value, sizeof(value));
+      rpc_channel_reply_commit(&ch, evt->event_id, sizeof(value));
+    } else {
+      assert(rpc_channel_reply(&ch, evt->event_id, &value, sizeof(value)));
+    }
+    rpc_channel_pop_request(&ch);
+    served++;
+  }
+  assert(served == 4);
+
+  for (uint32_t i = 0; i < 4; i++) {
+    assert(rpc_channel_wait(&ch, handles[i], 0, &reply, &reply_len));
+    assert(reply_len == sizeof(uint32_t));
+    assert(*(uint32_t *)reply == i * 10);
+    rpc_channel_release(&ch, handles[i]);
+  }
+
+  // A reply too large for the slot is refused
+  assert(rpc_channel_call(&ch, &request, sizeof(request), &handles[0]));
+  assert(!rpc_channel_reply(&ch, handles[0], reply_buffer, 33));
+
+  // A caller that gives up frees its slot and late replies are dropped
+  assert(!rpc_channel_wait(&ch, handles[0], 1000, &reply, &reply_len));
+  assert(!rpc_channel_reply(&ch, handles[0], &request, sizeof(request)));
+  assert(rpc_channel_reply_buffer(&ch, handles[0]) == NULL);
+
+  // Replying to a stale handle does not complete the slot's new call
+  assert(rpc_channel_call(&ch, &request, sizeof(request), &handles[1]));
+  rpc_channel_release(&ch, handles[1]);
+  for (uint32_t i = 0; i < 4; i++) {
+    assert(rpc_channel_call(&ch, &request, sizeof(request), &handles[i]));
+  }
+  assert(!rpc_channel_reply(&ch, handles[0] - (1U << RPC_CHANNEL_SLOT_BITS),
+                            &request, sizeof(request)));
+
+  // The deadline holds while the server builds the reply, the commit then
+  // frees the abandoned slot
+  config.slot_count = 1;
+  assert(rpc_channel_init(&ch, &config));
+  assert(rpc_channel_call(&ch, &request, sizeof(request), &handles[0]));
+  assert(rpc_channel_reply_buffer(&ch, handles[0]) != NULL);
+  assert(!rpc_channel_wait(&ch, handles[0], 1000000, &reply, &reply_len));
+  assert(!rpc_channel_call(&ch, &request, sizeof(request), &handles[1]));
+  rpc_channel_reply_commit(&ch, handles[0], sizeof(request));
+  assert(rpc_channel_call(&ch, &request, sizeof(request), &handles[1]));
+  assert(rpc_channel_get_request(&ch)->event_id == handles[0]);
+  rpc_channel_pop_request(&ch);
+  assert(rpc_channel_get_request(&ch)->event_id == handles[1]);
+
+#if defined(TEST_THREADS)
+  // A parked caller sleeps through a slow reply and is woken by the commit
+  config.wait.park = true;
+  assert(rpc_channel_init(&ch, &config));
+  rpc_caller_t caller = {.ch = &ch};
+  pthread_t thread;
+  for (uint32_t i = 0; i < 2; i++) {
+    request = i;
+    assert(rpc_channel_call(&ch, &request, sizeof(request), &caller.handle));
+    assert(pthread_create(&thread, NULL, rpc_caller_wait, &caller) == 0);
+    sleep_ns(2000000);
+    evt = rpc_channel_get_request(&ch);
+    assert(evt != NULL && evt->event_id == caller.handle);
+    uint8_t *const buffer = rpc_channel_reply_buffer(&ch, evt->event_id);
+    assert(buffer != NULL);
+    if (i == 1) {
+      // Parked while the reply is built
+      sleep_ns(2000000);
+    }
+    memcpy(buffer, &request, sizeof(request));
+    rpc_channel_reply_commit(&ch, evt->event_id, sizeof(request));
+    rpc_channel_pop_request(&ch);
+    assert(pthread_join(thread, NULL) == 0);
+    assert(caller.replied && caller.reply == i);
+    rpc_channel_release(&ch, caller.handle);
+  }
+#endif
+}
+
+/**
+ * Test fan-out of reference counted shared payloads
+ */
+void test_event_queue_shared() {
+  static uint64_t pool_memory[4 * 64 / sizeof(uint64_t)];
+  payload_pool_t pool;
+  assert(!payload_pool_init(&pool, pool_memory, sizeof(pool_memory), 0));
+  assert(payload_pool_init(&pool, pool_memory, sizeof(pool_memory), 48));
+  assert(pool.payload_size >= 48);
+  assert(pool.blocks.free_count == 4);
+
+  uint8_t buffers[3][BUFFER_SIZE];
+  event_queue_t queues[3];
+  for (uint32_t i = 0; i < 3; i++) {
+    event_queue_config_t config = default_config(buffers[i], BUFFER_SIZE);
+    event_queue_init(&queues[i], &config);
+  }
+
+  // Fan one payload out to every queue, then drop the producer's reference
+  uint8_t *payload = payload_pool_alloc(&pool);
+  assert(payload != NULL);
+  for (uint32_t i = 0; i < 40; i++) {
+    payload[i] = (uint8_t)i;
+  }
+  assert(!event_queue_put_shared(&queues[0], 7, payload,
+                                 pool.payload_size + 1));
+  for (uint32_t i = 0; i < 3; i++) {
+    assert(event_queue_put_shared(&queues[i], 7, payload, 40));
+  }
+  payload_release(payload);
+  assert(pool.blocks.free_count == 3);
+
+  // Only the pointer is stored in the ring
+  assert(queues[0]._cb.fill_count < 40);
+  assert(event_queue_put(&queues[0], 8, payload, 4));
+
+  for (uint32_t i = 0; i < 3; i++) {
+    event_t *out_event = event_queue_get(&queues[i]);
+    assert(out_event != NULL);
+    assert(out_event->event_id == 7);
+    assert(out_event->event_data == payload);
+    assert(out_event->event_data_length == 40);
+    assert(memcmp(out_event->event_data, payload, 40) == 0);
+    event_queue_pop(&queues[i]);
+    assert(pool.blocks.free_count == (i < 2 ? 3U : 4U));
+  }
+  event_t *out_event = event_queue_get(&queues[0]);
+  assert(out_event != NULL && out_event->event_id == 8);
+  event_queue_pop(&queues[0]);
+
+  // Filtered and cleared events drop their reference too
+  static uint64_t bitmap[1];
+  event_filter_t filter;
+  event_filter_init(&filter, bitmap, 1, NULL, 0);
+  event_filter_add(&filter, 1);
+  event_queue_set_filter(&queues[0], &filter);
+  payload = payload_pool_alloc(&pool);
+  assert(event_queue_put_shared(&queues[0], 2, payload, 8));
+  assert(event_queue_put_shared(&queues[1], 2, payload, 8));
+  assert(event_queue_put_shared(&queues[2], 2, payload, 8));
+  payload_release(payload);
+  assert(event_queue_get(&queues[0]) == NULL);
+  assert(queues[0].stats.filtered == 1);
+  event_queue_clear(&queues[1]);
+  assert(pool.blocks.free_count == 3);
+  event_queue_clear(&queues[2]);
+  assert(pool.blocks.free_count == 4);
+}
+
+static uint32_t notify_count = 0;
+static void test_notify(void *const context) {
+  assert(context == &notify_count);
+  notify_count++;
+}
+
+/**
+ * Test the consumer notify armed by event_queue_arm_notify
+ */
+void test_event_queue_notify() {
+  uint8_t buffer[BUFFER_SIZE];
+  event_queue_t eq;
+  event_queue_config_t config = default_config(buffer, BUFFER_SIZE);
+  config.notify = test_notify;
+  config.notify_context = &notify_count;
+  event_queue_init(&eq, &config);
+  uint32_t data = 0;
+
+  // Not armed, no notify
+  assert(event_queue_put(&eq, 1, &data, sizeof(data)));
+  assert(notify_count == 0);
+
+  // An event is available, arming declines
+  assert(!event_queue_arm_notify(&eq));
+  event_queue_pop(&eq);
+
+  // Armed on an empty queue, exactly one put notifies
+  assert(event_queue_arm_notify(&eq));
+  assert(event_queue_put(&eq, 2, &data, sizeof(data)));
+  assert(event_queue_put(&eq, 3, &data, sizeof(data)));
+  assert(notify_count == 1);
+
+  // A failed put does not notify
+  event_queue_pop(&eq);
+  event_queue_pop(&eq);
+  assert(event_queue_arm_notify(&eq));
+  assert(!event_queue_put(&eq, 4, buffer, BUFFER_SIZE));
+  assert(notify_count == 1);
+  assert(event_queue_put(&eq, 5, &data, sizeof(data)));
+  assert(notify_count == 2);
+}
+
+static uint64_t timestamp_key(const event_t *const evt, void *const context) {
+  uint64_t timestamp;
+  memcpy(&timestamp, evt->event_data, sizeof(timestamp));
+  (*(uint32_t *)context)++;
+  return timestamp;
+}
+
+/**
+ * Test key ordered consumption of several queues
+ */
+void test_merge_reader() {
+  uint8_t buffers[4][BUFFER_SIZE];
+  event_queue_t queues[4];
+  event_queue_t *queue_ptrs[4];
+  for (uint32_t i = 0; i < 4; i++) {
+    event_queue_config_t config = default_config(buffers[i], BUFFER_SIZE);
+    event_queue_init(&queues[i], &config);
+    queue_ptrs[i] = &queues[i];
+  }
+  merge_reader_entry_t heap[4];
+  uint32_t idle[4];
+  uint32_t key_reads = 0;
+  merge_reader_t mr;
+  merge_reader_config_t config = {.queues = queue_ptrs,
+                                  .queue_count = 4,
+                                  .heap = heap,
+                                  .idle = idle,
+                                  .key = NULL,
+                                  .key_context = &key_reads};
+  assert(!merge_reader_init(&mr, &config));
+  config.key = timestamp_key;
+  assert(merge_reader_init(&mr, &config));
+  assert(merge_reader_get(&mr, NULL) == NULL);
+
+  // Queue i holds timestamps i, i + 4, i + 8, ... with queue 3 left empty
+  for (uint64_t t = 0; t < 24; t++) {
+    if (t % 4 != 3) {
+      assert(event_queue_put(&queues[t % 4], (event_id_t)t, &t, sizeof(t)));
+    }
+  }
+
+  uint64_t expected = 0;
+  uint32_t queue;
+  event_t *evt;
+  while ((evt = merge_reader_get(&mr, &queue)) != NULL) {
+    if (expected % 4 == 3 && expected != 11) {
+      expected++;
+    }
+    assert(evt->event_id == expected);
+    assert(queue == expected % 4);
+    merge_reader_pop(&mr);
+    expected++;
+    if (expected == 9) {
+      // A queue that was empty joins the merge once polled
+      const uint64_t t = 11;
+      assert(event_queue_put(&queues[3], 11, (void *)&t, sizeof(t)));
+      merge_reader_poll(&mr);
+    }
+  }
+  assert(expected == 23);
+
+  // Each event's key is read once
+  assert(key_reads == 19);
+
+  // Equal keys come out in queue order
+  const uint64_t t = 100;
+  assert(event_queue_put(&queues[2], 2, (void *)&t, sizeof(t)));
+  assert(event_queue_put(&queues[0], 0, (void *)&t, sizeof(t)));
+  assert(event_queue_put(&queues[1], 1, (void *)&t, sizeof(t)));
+  for (event_id_t id = 0; id < 3; id++) {
+    evt = merge_reader_get(&mr, NULL);
+    assert(evt != NULL && evt->event_id == id);
+    merge_reader_pop(&mr);
+  }
+  assert(merge_reader_get(&mr, NULL) == NULL);
+
+  // Without a poll, an empty queue is rechecked only once the others drain
+  const uint64_t keys[] = {200, 300, 150};
+  assert(event_queue_put(&queues[0], 0, (void *)&keys[0], sizeof(keys[0])));
+  assert(event_queue_put(&queues[0], 1, (void *)&keys[1], sizeof(keys[1])));
+  evt = merge_reader_get(&mr, NULL);
+  assert(evt != NULL && evt->event_id == 0);
+  assert(event_queue_put(&queues[1], 2, (void *)&keys[2], sizeof(keys[2])));
+  evt = merge_reader_get(&mr, NULL);
+  assert(evt != NULL && evt->event_id == 0);
+  merge_reader_pop(&mr);
+  evt = merge_reader_get(&mr, NULL);
+  assert(evt != NULL && evt->event_id == 1);
+  merge_reader_poll(&mr);
+  evt = merge_reader_get(&mr, &queue);
+  assert(evt != NULL && evt->event_id == 2 && queue == 1);
+  merge_reader_pop(&mr);
+  evt = merge_reader_get(&mr, NULL);
+  assert(evt != NULL && evt->event_id == 1);
+  merge_reader_pop(&mr);
+  assert(merge_reader_get(&mr, NULL) == NULL);
+}
+
+/**
+ * Test placing several events with a single reservation
+ */
+void test_event_queue_put_batch() {
+  uint8_t buffer[BUFFER_SIZE];
+  event_queue_t eq;
+  event_queue_config_t config = default_config(buffer, BUFFER_SIZE);
+  event_queue_init(&eq, &config);
+  uint8_t data[64];
+  for (uint32_t i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)i;
+  }
+
+  // Records are 4 + 16 + 64 bytes, six fit in the buffer
+  event_t events[8];
+  for (uint32_t i = 0; i < 8; i++) {
+    events[i].event_id = i;
+    events[i].event_data = data;
+    events[i].event_data_length = sizeof(data);
+  }
+  assert(event_queue_put_batch(&eq, events, 0) == 0);
+  assert(event_queue_put_batch(&eq, events, 8) == 6);
+  assert(eq._cb.fill_count == 6 * 84);
+  assert(event_queue_put_batch(&eq, events, 1) == 0);
+
+  for (uint32_t i = 0; i < 6; i++) {
+    event_t *out_event = event_queue_get(&eq);
+    assert(out_event != NULL && out_event->event_id == i);
+    assert(memcmp(out_event->event_data, data, sizeof(data)) == 0);
+    event_queue_pop(&eq);
+  }
+
+  // A run wraps as a whole when it does not fit before the end
+  assert(event_queue_put_batch(&eq, events, 2) == 2);
+  event_queue_pop(&eq);
+  assert(event_queue_get(&eq) != NULL);
+  assert(event_queue_put_batch(&eq, &events[2], 4) == 4);
+  for (uint32_t i = 1; i < 6; i++) {
+    event_t *out_event = event_queue_get(&eq);
+    assert(out_event != NULL && out_event->event_id == i);
+    event_queue_pop(&eq);
+  }
+  assert(event_queue_get(&eq) == NULL);
+
+  // Free space behind a wrapped head is a single run
+  event_queue_init(&eq, &config);
+  assert(event_queue_put_batch(&eq, events, 5) == 5);
+  for (uint32_t i = 0; i < 5; i++) {
+    event_queue_pop(&eq);
+  }
+  assert(event_queue_put_batch(&eq, events, 4) == 4);
+  assert(event_queue_put_batch(&eq, &events[4], 4) == 1);
+}
+
+/**
+ * Test producer staging flushed on count, byte and delay thresholds
+ */
+void test_event_stage() {
+  uint8_t buffer[BUFFER_SIZE];
+  event_queue_t eq;
+  event_queue_config_t eq_config = default_config(buffer, BUFFER_SIZE);
+  event_queue_init(&eq, &eq_config);
+  event_t events[4];
+  uint8_t data[64];
+  event_stage_t stage;
+  event_stage_config_t config = {.eq = &eq,
+                                 .events = events,
+                                 .max_events = 4,
+                                 .data = data,
+                                 .data_len = sizeof(data),
+                                 .flush_bytes = 32,
+                                 .max_delay_ns = 0};
+  uint32_t value = 0;
+
+  event_stage_config_t bad = config;
+  bad.max_events = 0;
+  assert(!event_stage_init(&stage, &bad));
+  assert(event_stage_init(&stage, &config));
+
+  // Count threshold
+  for (uint32_t i = 0; i < 3; i++) {
+    value = i;
+    assert(event_stage_put(&stage, i, &value, sizeof(value)));
+  }
+  assert(event_queue_get(&eq) == NULL);
+  value = 3;
+  assert(event_stage_put(&stage, 3, &value, sizeof(value)));
+  assert(stage.count == 0);
+  for (uint32_t i = 0; i < 4; i++) {
+    event_t *out_event = event_queue_get(&eq);
+    assert(out_event != NULL && out_event->event_id == i);
+    assert(*(uint32_t *)out_event->event_data == i);
+    event_queue_pop(&eq);
+  }
+
+  // Byte threshold
+  assert(event_stage_put(&stage, 4, data, 20));
+  assert(stage.count == 1);
+  assert(event_stage_put(&stage, 5, data, 12));
+  assert(stage.count == 0);
+
+  // Explicit flush
+  assert(event_stage_put(&stage, 6, &value, sizeof(value)));
+  assert(event_stage_flush(&stage) == 1);
+  assert(event_stage_flush(&stage) == 0);
+
+  // Too large for the stage
+  assert(!event_stage_put(&stage, 7, buffer, sizeof(data) + 1));
+  event_queue_clear(&eq);
+
+  // Delay threshold
+  config.flush_bytes = 0;
+  config.max_delay_ns = 1000000;
+  assert(event_stage_init(&stage, &config));
+  assert(event_stage_put(&stage, 8, &value, sizeof(value)));
+  assert(event_stage_poll(&stage) == 0);
+  const uint64_t start = event_clock_monotonic_ns();
+  while (event_clock_monotonic_ns() - start < 2000000) {
+  }
+  assert(event_stage_poll(&stage) == 1);
+
+  // A full queue keeps the rest staged, in order
+  event_queue_init(&eq, &eq_config);
+  config.max_delay_ns = 0;
+  assert(event_stage_init(&stage, &config));
+  uint32_t placed = 0;
+  while (event_queue_put(&eq, 0, data, 60)) {
+    placed++;
+  }
+  event_queue_pop(&eq);
+  assert(event_stage_put(&stage, 10, data, 30));
+  assert(event_stage_put(&stage, 11, data + 30, 30));
+  assert(event_stage_flush(&stage) == 1);
+  assert(stage.count == 1 && stage.length == 30);
+  assert(events[0].event_id == 11 && events[0].event_data == data);
+  for (uint32_t i = 0; i < placed; i++) {
+    event_queue_pop(&eq);
+  }
+  assert(event_stage_flush(&stage) == 1);
+  event_t *out_event = event_queue_get(&eq);
+  assert(out_event != NULL && out_event->event_id == 11);
+
+  // An event too large for the queue is refused instead of wedging the stage
+  static uint8_t large_data[2 * BUFFER_SIZE];
+  event_queue_init(&eq, &eq_config);
+  config.data = large_data;
+  config.data_len = sizeof(large_data);
+  assert(event_stage_init(&stage, &config));
+  assert(!event_stage_put(&stage, 12, large_data, BUFFER_SIZE));
+  assert(event_stage_put(&stage, 13, large_data, 4));
+  assert(event_stage_flush(&stage) == 1);
+  out_event = event_queue_get(&eq);
+  assert(out_event != NULL && out_event->event_id == 13);
+}
+
+/**
+ * Test the payload codec round trip and corrupt input
+ */
+void test_event_compress() {
+  static uint8_t src[8192];
+  static uint8_t compressed[8192 + 8192 / 255 + 16];
+  static uint8_t out[8192];
+
+  // Repetitive data with short literal runs between long matches
+  for (uint32_t i = 0; i < sizeof(src); i++) {
+    src[i] = (i % 300 < 20) ? (uint8_t)rand() : (uint8_t)(i % 7);
+  }
+  uint32_t len = event_compress(src, sizeof(src), compressed,
+                                sizeof(compressed));
+  assert(len > 0 && len < sizeof(src) / 4);
+  assert(event_decompress(compressed, len, out, sizeof(out)) == sizeof(src));
+  assert(memcmp(src, out, sizeof(src)) == 0);
+
+  // Output too small to hold the data
+  assert(event_decompress(compressed, len, out, sizeof(out) - 1) == 0);
+
+  // Truncated input decodes short, corrupt input never writes past the output
+  for (uint32_t cut = 1; cut < len - 1; cut += len / 16 + 1) {
+    assert(event_decompress(compressed, cut, out, sizeof(out)) < sizeof(src));
+  }
+  for (uint32_t i = 0; i < 100; i++) {
+    uint8_t corrupt[sizeof(compressed)];
+    memcpy(corrupt, compressed, len);
+    corrupt[rand() % len] ^= (uint8_t)(1 + rand() % 255);
+    assert(event_decompress(corrupt, len, out, sizeof(out)) <= sizeof(out));
+  }
+
+  // Random data does not compress, nor does empty or tiny data
+  for (uint32_t i = 0; i < sizeof(src); i++) {
+    src[i] = (uint8_t)rand();
+  }
+  assert(event_compress(src, sizeof(src), compressed, sizeof(compressed)) ==
+         0);
+  assert(event_compress(src, 0, compressed, sizeof(compressed)) == 0);
+  assert(event_compress(src, 3, compressed, sizeof(compressed)) == 0);
+
+  // Long runs, including lengths that continue past the token
+  memset(src, 'a', sizeof(src));
+  for (uint32_t size = 4; size <= sizeof(src); size = size * 3 + 1) {
+    len = event_compress(src, size, compressed, sizeof(compressed));
+    if (len > 0) {
+      assert(event_decompress(compressed, len, out, sizeof(out)) == size);
+      assert(memcmp(src, out, size) == 0);
+    }
+  }
+
+  // A destination too small to hold the compressed output
+  assert(event_compress(src, sizeof(src), compressed, 8) == 0);
+}
+
+/**
+ * Test in-ring compression of large event data
+ */
+void test_event_queue_compress() {
+  static uint8_t buffer[4096];
+  static uint8_t data[1024];
+  static uint8_t out[1024];
+  latency_histogram_t histogram;
+  event_queue_t eq;
+  event_queue_config_t config = default_config(buffer, sizeof(buffer));
+  config.compress_threshold = 256;
+  config.latency_histogram = &histogram;
+  event_queue_init(&eq, &config);
+
+  for (uint32_t i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)(i % 16);
+  }
+
+  // Several times more repetitive events fit than the buffer holds raw
+  uint32_t placed = 0;
+  while (event_queue_put_expiry(&eq, placed, data, sizeof(data), UINT64_MAX)) {
+    placed++;
+  }
+  assert(placed > 3 * (sizeof(buffer) / sizeof(data)));
+
+  for (uint32_t i = 0; i < placed; i++) {
+    event_t *out_event = event_queue_get(&eq);
+    assert(out_event != NULL && out_event->event_id == i);
+    assert(out_event->event_data_length < sizeof(data));
+    assert(event_queue_data_length(out_event) == sizeof(data));
+    assert(!event_queue_read_data(out_event, out, sizeof(data) - 1));
+    assert(event_queue_read_data(out_event, out, sizeof(out)));
+    assert(memcmp(data, out, sizeof(data)) == 0);
+    event_queue_pop(&eq);
+  }
+  assert(histogram.total_count == placed);
+
+  // Below the threshold and incompressible data are stored as is
+  for (uint32_t i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)rand();
+  }
+  assert(event_queue_put(&eq, 1, data, 255));
+  assert(event_queue_put(&eq, 2, data, sizeof(data)));
+  for (event_id_t id = 1; id <= 2; id++) {
+    event_t *out_event = event_queue_get(&eq);
+    assert(out_event != NULL && out_event->event_id == id);
+    assert(event_queue_data_length(out_event) ==
+           out_event->event_data_length);
+    assert(memcmp(out_event->event_data, data,
+                  out_event->event_data_length) == 0);
+    assert(event_queue_read_data(out_event, out, sizeof(out)));
+    event_queue_pop(&eq);
+  }
+  assert(event_queue_get(&eq) == NULL);
+}
+
 /**
  * Main
  */
@@ -443,10 +1996,33 @@ int main(int argc, char *argv[]) {
   test_event_queue_empty();
   test_event_queue_fuzz_event_data_length();
   test_lock_unlock();
+  test_lock_unlock_full();
   test_circular_buffer_clear();
   test_event_queue_clear();
   test_event_queue_init_invalid_params();
   test_circular_buffer_atomic_operations();
   test_circular_buffer_produce_bytes();
+  test_latency_histogram();
+  test_event_queue_latency();
+  test_event_queue_iov();
+  test_event_capture();
+  test_block_pool();
+  test_segmented_queue();
+  test_event_queue_put_timeout();
+  test_event_queue_alloc();
+  test_event_copy();
+  test_slot_queue();
+  test_event_filter();
+  test_event_queue_filter();
+  test_event_queue_expiry();
+  test_work_queue();
+  test_rpc_channel();
+  test_event_queue_shared();
+  test_event_queue_notify();
+  test_merge_reader();
+  test_event_queue_put_batch();
+  test_event_stage();
+  test_event_compress();
+  test_event_queue_compress();
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,206 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "event_queue_coro.hpp"
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#define BUFFER_SIZE (uint32_t)512
+
+// Coroutine that starts immediately and is destroyed on completion
+struct task {
+  struct promise_type {
+    task get_return_object() { return task(); }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() {}
+  };
+};
+
+static event_queue_config_t default_config(void *buffer,
+                                           uint32_t buffer_size) {
+  event_queue_config_t eq_config = {};
+  eq_config.buffer = buffer;
+  eq_config.buffer_len = buffer_size;
+  eq_config.alignment = 4;
+  return eq_config;
+}
+
+static task consume(eeq::event_queue_coro &q, event_queue_t &eq,
+                    event_id_t *const ids, const uint32_t count,
+                    uint32_t &received) {
+  while (received < count) {
+    event_t *const evt = co_await q.next();
+    assert(evt != nullptr);
+    ids[received++] = evt->event_id;
+    event_queue_pop(&eq);
+  }
+}
+
+static task consume_batches(eeq::event_queue_coro &q, event_queue_t &eq,
+                            uint32_t *const batches, const uint32_t count,
+                            uint32_t &received) {
+  struct iovec iov[4];
+  while (received < count) {
+    const uint32_t n = co_await q.next_batch(iov, 4);
+    assert(n > 0);
+    uint32_t bytes = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      bytes += iov[i].iov_len;
+    }
+    assert(event_queue_release_iov(&eq, bytes, false) == bytes);
+    batches[received++] = n;
+  }
+}
+
+void test_coro_inline_resume() {
+  uint8_t buffer[BUFFER_SIZE];
+  event_queue_t eq;
+  event_queue_config_t config = default_config(buffer, BUFFER_SIZE);
+  assert(event_queue_init(&eq, &config));
+  eeq::event_queue_coro q(eq);
+  event_id_t ids[4] = {};
+  uint32_t received = 0;
+  uint32_t data = 0;
+
+  // An event queued before the coroutine starts is taken without suspending
+  assert(event_queue_put(&eq, 10, &data, sizeof(data)));
+  consume(q, eq, ids, 4, received);
+  assert(received == 1);
+
+  // Each put resumes the suspended coroutine on the producer's thread
+  for (uint32_t i = 1; i < 4; i++) {
+    assert(event_queue_put(&eq, 10 + i, &data, sizeof(data)));
+    assert(received == i + 1);
+  }
+  for (uint32_t i = 0; i < 4; i++) {
+    assert(ids[i] == 10 + i);
+  }
+
+  // Once the coroutine finished, puts no longer notify
+  assert(event_queue_put(&eq, 20, &data, sizeof(data)));
+  assert(received == 4);
+}
+
+static void defer(std::coroutine_handle<> handle, void *const context) {
+  *static_cast<std::coroutine_handle<> *>(context) = handle;
+}
+
+void test_coro_executor() {
+  uint8_t buffer[BUFFER_SIZE];
+  event_queue_t eq;
+  event_queue_config_t config = default_config(buffer, BUFFER_SIZE);
+  assert(event_queue_init(&eq, &config));
+  std::coroutine_handle<> pending;
+  eeq::event_queue_coro q(eq, defer, &pending);
+  uint32_t batches[2] = {};
+  uint32_t received = 0;
+  uint32_t data = 0;
+
+  consume_batches(q, eq, batches, 2, received);
+  assert(received == 0 && !pending);
+
+  // The executor decides when the woken coroutine runs
+  assert(event_queue_put(&eq, 1, &data, sizeof(data)));
+  assert(pending);
+  assert(event_queue_put(&eq, 2, &data, sizeof(data)));
+  assert(received == 0);
+  std::coroutine_handle<> handle = pending;
+  pending = nullptr;
+  handle.resume();
+  assert(received == 1 && batches[0] == 2);
+
+  // Only one notify per wait
+  assert(event_queue_put(&eq, 3, &data, sizeof(data)));
+  assert(event_queue_put(&eq, 4, &data, sizeof(data)));
+  assert(event_queue_put(&eq, 5, &data, sizeof(data)));
+  handle = pending;
+  pending = nullptr;
+  handle.resume();
+  assert(received == 2 && batches[1] == 3);
+  assert(!pending);
+}
+
+#define PRODUCER_EVENTS (uint32_t)20000
+
+static std::mutex producer_mutex;
+static void producer_lock() { producer_mutex.lock(); }
+static void producer_unlock() { producer_mutex.unlock(); }
+
+static task consume_sequences(eeq::event_queue_coro &q, event_queue_t &eq,
+                              uint32_t *const next_seq, const uint32_t count,
+                              uint32_t &received) {
+  while (received < count) {
+    event_t *const evt = co_await q.next();
+    assert(evt != nullptr);
+    uint32_t seq;
+    memcpy(&seq, evt->event_data, sizeof(seq));
+    assert(seq == next_seq[evt->event_id]);
+    next_seq[evt->event_id]++;
+    received++;
+    event_queue_pop(&eq);
+  }
+}
+
+static void produce_sequences(event_queue_t *const eq, const event_id_t id) {
+  for (uint32_t seq = 0; seq < PRODUCER_EVENTS; seq++) {
+    while (!event_queue_put(eq, id, &seq, sizeof(seq))) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void test_coro_threaded_resume() {
+  uint8_t buffer[BUFFER_SIZE];
+  event_queue_t eq;
+  event_queue_config_t config = default_config(buffer, BUFFER_SIZE);
+  config.use_atomics = true;
+  config.lock = producer_lock;
+  config.unlock = producer_unlock;
+  assert(event_queue_init(&eq, &config));
+  eeq::event_queue_coro q(eq);
+  uint32_t next_seq[2] = {};
+  uint32_t received = 0;
+
+  // Either producer may resume the coroutine while the other one's resume is
+  // still suspending it, the coroutine must never run on both at once
+  consume_sequences(q, eq, next_seq, 2 * PRODUCER_EVENTS, received);
+  std::thread first(produce_sequences, &eq, 0);
+  std::thread second(produce_sequences, &eq, 1);
+  first.join();
+  second.join();
+  assert(received == 2 * PRODUCER_EVENTS);
+  assert(next_seq[0] == PRODUCER_EVENTS && next_seq[1] == PRODUCER_EVENTS);
+  assert(eq._cb.fill_count == 0);
+}
+
+/**
+ * Main
+ */
+int main(int argc, char *argv[]) {
+  test_coro_inline_resume();
+  test_coro_executor();
+  test_coro_threaded_resume();
+  return 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "work_queue.h"
+#include <limits.h>
+
+static inline bool work_queue_try_lock(volatile atomic_int_t *const lock) {
+  int expected = 0;
+  return atomic_load(lock) == 0 &&
+         atomic_compare_exchange_strong(lock, &expected, 1);
+}
+
+static inline void work_queue_unlock(volatile atomic_int_t *const lock) {
+  atomic_store(lock, 0);
+}
+
+/**
+ * Handle events from a shard, if no other worker is consuming it
+ *
+ * @return Number of events handled
+ */
+static uint32_t work_queue_drain(work_queue_shard_t *const shard,
+                                 work_queue_handler_t handler,
+                                 void *const context, const uint32_t max) {
+  uint32_t count = 0;
+  if (!work_queue_try_lock(&shard->consume_lock)) {
+    return 0;
+  }
+  event_t *evt;
+  while (count < max && (evt = event_queue_get(&shard->eq)) != NULL) {
+    handler(evt, context);
+    event_queue_pop(&shard->eq);
+    count++;
+  }
+  work_queue_unlock(&shard->consume_lock);
+  return count;
+}
+
+bool work_queue_init(work_queue_t *const wq,
+                     work_queue_config_t *const config) {
+  if (config->buffer == NULL || config->shards == NULL)
+    return false;
+  if (config->shard_count == 0)
+    return false;
+  const uint32_t shard_len = (config->buffer_len / config->shard_count) & ~7U;
+  if (shard_len == 0)
+    return false;
+  memcpy(&wq->config, config, sizeof(work_queue_config_t));
+  if (wq->config.steal_batch == 0) {
+    wq->config.steal_batch = 1;
+  }
+
+  for (uint32_t i = 0; i < config->shard_count; i++) {
+    work_queue_shard_t *const shard = &config->shards[i];
+    event_queue_config_t eq_config = {
+        .buffer = (uint8_t *)config->buffer + (size_t)i * shard_len,
+        .buffer_len = shard_len,
+        .alignment = config->alignment,
+        .use_atomics = true,
+        .lock = NULL,
+        .unlock = NULL};
+    event_queue_init(&shard->eq, &eq_config);
+    atomic_store(&shard->consume_lock, 0);
+    atomic_store(&shard->produce_lock, 0);
+  }
+  return true;
+}
+
+bool work_queue_put(work_queue_t *const wq, const uint32_t shard,
+                    const event_id_t event_id, void *const event_data,
+                    const uint32_t event_data_len) {
+  work_queue_shard_t *const s = &wq->config.shards[shard];
+  if (wq->config.multi_producer) {
+    while (!work_queue_try_lock(&s->produce_lock)) {
+      event_wait_pause();
+    }
+  }
+  const bool placed =
+      event_queue_put(&s->eq, event_id, event_data, event_data_len);
+  if (wq->config.multi_producer) {
+    work_queue_unlock(&s->produce_lock);
+  }
+  return placed;
+}
+
+uint32_t work_queue_consume(work_queue_t *const wq, const uint32_t worker,
+                            work_queue_handler_t handler, void *const context,
+                            const uint32_t max) {
+  const uint32_t count =
+      work_queue_drain(&wq->config.shards[worker], handler, context, max);
+  if (count > 0) {
+    return count;
+  }
+
+  // Own shard is empty, steal from the shard with the most queued bytes. If
+  // another worker is consuming it, fall through to the next busiest, ranking
+  // candidates by fill then index so each shard is tried at most once.
+  int last_fill = INT_MAX;
+  uint32_t last_victim = 0;
+  for (;;) {
+    uint32_t victim = worker;
+    int most = 0;
+    for (uint32_t i = 0; i < wq->config.shard_count; i++) {
+      const int fill = atomic_load(&wq->config.shards[i].eq._cb.fill_count);
+      if (i == worker || fill <= most || fill > last_fill ||
+          (fill == last_fill && i <= last_victim)) {
+        continue;
+      }
+      most = fill;
+      victim = i;
+    }
+    if (victim == worker) {
+      return 0;
+    }
+    const uint32_t stolen = work_queue_drain(
+        &wq->config.shards[victim], handler, context, wq->config.steal_batch);
+    if (stolen > 0) {
+      return stolen;
+    }
+    last_fill = most;
+    last_victim = victim;
+  }
+}
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2025 Nicholas Daniell
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "event_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define WORK_QUEUE_CACHE_LINE 64
+
+typedef void (*work_queue_handler_t)(event_t *const evt, void *const context);
+
+typedef struct {
+  event_queue_t eq;                    // Shard ring
+  volatile atomic_int_t consume_lock;  // Held by whoever consumes the shard
+  volatile atomic_int_t produce_lock;  // Held by producers, if multi_producer
+  uint8_t _pad[WORK_QUEUE_CACHE_LINE]; // Keep shards off each other's lines
+} work_queue_shard_t;
+
+typedef struct {
+  void *buffer;               // Ring memory, split evenly between shards
+  uint32_t buffer_len;        // Size of ring memory
+  work_queue_shard_t *shards; // One shard per worker
+  uint32_t shard_count;       // Number of shards
+  uint32_t alignment;         // Event alignment
+  uint32_t steal_batch;       // Events taken from a victim at once
+  bool multi_producer;        // Serialize producers of each shard
+} work_queue_config_t;
+
+typedef struct {
+  work_queue_config_t config;
+} work_queue_t;
+
+/**
+ * Initialize a sharded work queue
+ *
+ *  Each worker owns a shard ring. Workers consume their own shard, and when
+ *  it is empty steal a batch of events from the tail of the busiest shard.
+ *
+ * @param wq Work Queue
+ * @param config Work Queue Configuration
+ * @return false if the buffer cannot be split between the shards
+ */
+bool work_queue_init(work_queue_t *const wq,
+                     work_queue_config_t *const config);
+
+/**
+ * Put an event on a shard of the work queue
+ *
+ * @param wq Work Queue
+ * @param shard Shard index, typically the producing worker
+ * @param event_id Event identifier
+ * @param event_data Data to accompany event
+ * @param event_data_len Size of event data
+ * @return false if the shard is full
+ */
+bool work_queue_put(work_queue_t *const wq, const uint32_t shard,
+                    const event_id_t event_id, void *const event_data,
+                    const uint32_t event_data_len);
+
+/**
+ * Process events as a worker
+ *
+ *  Handles up to max events from the worker's shard. If it is empty, handles
+ *  up to steal_batch events from the busiest other shard instead, or from the
+ *  next busiest while another worker is consuming it. Events are handled in
+ *  place and removed once the handler returns.
+ *
+ * @param wq Work Queue
+ * @param worker Worker index, the shard it owns
+ * @param handler Called for each event
+ * @param context Passed to the handler
+ * @param max Maximum number of events from the worker's own shard
+ * @return Number of events handled
+ */
+uint32_t work_queue_consume(work_queue_t *const wq, const uint32_t worker,
+                            work_queue_handler_t handler, void *const context,
+                            const uint32_t max);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // WORK_QUEUE_H